@@ -10,35 +10,208 @@
 
 #include "Config.h"
 #include "Code.h"
+#include "LineScanner.h"
+#include "MemoryMap.h"
 #include "Parser.h"
+#include "Stats.h"
 #include "SymbolTable.h"
 
+/**
+ * @brief Copies an indexed line into a buffer with whitespace removed
+ * 
+ * @param input Input file contents
+ * @param line The indexed line
+ * @param buffer Buffer of MAX_LINE_LENGTH bytes receiving the instruction
+ * @return The instruction, or NULL if the line is too long
+ */
+static char * loadInstruction(const char * input, const SourceLine * line, char * buffer) {
+    if (!copySourceLine(input, line, buffer, MAX_LINE_LENGTH)) {
+        fprintf(stderr, "Error: Line %u exceeds %d characters\n", line->number, MAX_LINE_LENGTH - 1);
+        return NULL;
+    }
+    return line->spaced ? removeWhitespace(buffer) : buffer;
+}
+
+/**
+ * @brief Runs one first pass over the input, recording label addresses
+ * 
+ * A-commands that reference a label whose currently known address exceeds
+ * MAX_SHORT_ADDRESS occupy two words (see LONG_ADDRESS_FIXUP), as do
+ * constants that constantWords does not fit in one instruction. Since label
+ * addresses only grow from one pass to the next, repeating this pass until
+ * no label moves converges on a consistent layout.
+ * 
+ * @param input Input file contents
+ * @param lines Index of the input's instruction lines
+ * @param symbolTable Pointer to the symbol table
+ * @param changed Set to true if any previously recorded label moved
+ * @return 0 on success, 1 on error
+ */
+static int firstPass(const char * input, const LineIndex * lines, SymbolTable * symbolTable, bool * changed) {
+    char currLine[MAX_LINE_LENGTH];
+    uint32_t romAddress = 0;
+    *changed = false;
+
+    for (size_t i = 0; i < lines->count; i++) {
+        char * trimmed = loadInstruction(input, &lines->lines[i], currLine);
+        if (trimmed == NULL) {
+            return 1;
+        }
+
+        int commandType = getCommandType(trimmed);
+        if (commandType == L_COMMAND) {
+            char * symbol = getSymbol(trimmed);
+            if (contains(symbolTable, symbol)) {
+                *changed |= setAddress(symbolTable, symbol, (uint16_t) romAddress);
+            } else {
+                addEntry(symbolTable, symbol, (uint16_t) romAddress);
+            }
+            free(symbol);
+        } else if (commandType == A_COMMAND) {
+            char * symbol = getSymbol(trimmed);
+            uint16_t value;
+            if (parseConstant(symbol, &value)) {
+                romAddress += constantWords(value);
+            } else {
+                if (contains(symbolTable, symbol) && getAddress(symbolTable, symbol) > MAX_SHORT_ADDRESS) {
+                    romAddress++;
+                }
+                romAddress++;
+            }
+            free(symbol);
+        } else if (commandType == C_COMMAND) {
+            romAddress++;
+        } else {
+            fprintf(stderr, "Error: Unknown command type\n");
+            return 1;
+        }
+
+        if (romAddress > MAX_ROM_ADDRESS) {
+            fprintf(stderr, "Error: Program exceeds %d instructions\n", MAX_ROM_ADDRESS);
+            return 1;
+        }
+    }
+
+    symbolTable->romAddress = (uint16_t) romAddress;
+    return 0;
+}
+
+/**
+ * @brief Writes the symbol table to a .sym file
+ * 
+ * The file starts with the memory map as six "M <address> <bound>" lines
+ * (bounds statics.base, statics.limit, stack.base, stack.limit, heap.base
+ * and heap.limit), so tools that run the program know the layout it was
+ * built for. Each following line has the form "L <address> <name>" for
+ * labels or "V <address> <name>" for variables. Predefined symbols are
+ * omitted. Labels are added during the first pass and variables during the
+ * second, so the position of an entry in the table identifies its kind.
+ * 
+ * @param symbolTable Pointer to the symbol table
+ * @param labelCount Number of labels recorded by the first pass
+ * @param map The memory map the program was assembled for
+ * @param fileName Path of the .sym file to write
+ * @param bytesWritten Incremented by the size of the file
+ * @return 0 on success, 1 on error
+ */
+static int writeSymbols(SymbolTable * symbolTable, uint16_t labelCount, const MemoryMap * map,
+                        const char * fileName, uint64_t * bytesWritten) {
+    FILE * symbolFile = fopen(fileName, "w");
+    if (symbolFile == NULL) {
+        perror("fopen symbols failed");
+        return 1;
+    }
+
+    int length = fprintf(symbolFile, "M %u statics.base\nM %u statics.limit\nM %u stack.base\n"
+                         "M %u stack.limit\nM %u heap.base\nM %u heap.limit\n",
+                         map->staticBase, map->staticLimit, map->stackBase,
+                         map->stackLimit, map->heapBase, map->heapLimit);
+    if (length > 0) {
+        *bytesWritten += (uint64_t) length;
+    }
+
+    uint16_t index = 0;
+    for (Symbol * curr = symbolTable->head; curr != NULL; curr = curr->next, index++) {
+        if (index < PREDEFINED_SYMBOLS) {
+            continue;
+        }
+        char kind = (index < PREDEFINED_SYMBOLS + labelCount) ? 'L' : 'V';
+        length = fprintf(symbolFile, "%c %u %s\n", kind, curr->address, curr->name);
+        if (length > 0) {
+            *bytesWritten += (uint64_t) length;
+        }
+    }
+
+    fclose(symbolFile);
+    return 0;
+}
+
 /**
  * @brief Main entry point for the Hack Assembler
  * 
  * Processes command line arguments, validates input file format, and orchestrates
- * the two-pass assembly process. The first pass builds the symbol table by
- * processing labels (L-commands), while the second pass generates binary code
- * for all assembly instructions.
+ * the two-pass assembly process. The input is read into memory and its
+ * instruction lines are indexed once (see LineScanner.h); the first
+ * pass builds the symbol table by processing labels (L-commands), while the
+ * second pass generates binary code for all assembly instructions into memory,
+ * which is then written out in one piece. With -s/--symbols the final symbol
+ * table is also written next to the output as a .sym file, which the emulator
+ * uses to locate functions by name and to learn the memory map. With --stats
+ * the time spent in each phase and the work counters are printed to stderr,
+ * and --scanner forces a line scanner backend instead of the fastest one.
+ * Variables are allocated from the static region of the memory map given by
+ * --statics, --stack and --heap (see MemoryMap.h), and running out of it is
+ * an error.
  * 
  * @param argc Number of command line arguments
  * @param argv Array of command line argument strings
  * @return 0 on successful assembly, 1 on error
  */
 int main(int argc, char * argv[]) {
-    if (argc != 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
-        fprintf(stderr, "Usage: Assembler [FILE]\n");
+    const char * inputName = NULL;
+    bool symbolsRequested = false;
+    bool statsRequested = false;
+    MemoryMap memoryMap;
+    initMemoryMap(&memoryMap);
+    for (int i = 1; i < argc; i++) {
+        int layoutOption = parseMemoryMapOption(&memoryMap, argc, argv, &i);
+        if (layoutOption < 0) {
+            return 1;
+        } else if (layoutOption > 0) {
+            continue;
+        } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--symbols") == 0) {
+            symbolsRequested = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            statsRequested = true;
+        } else if (strcmp(argv[i], "--scanner") == 0 && i + 1 < argc) {
+            if (!setLineScannerBackend(parseSimdBackend(argv[++i]))) {
+                fprintf(stderr, "Error: Scanner backend %s is unknown or not supported by this host\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || inputName != NULL) {
+            inputName = NULL;
+            break;
+        } else {
+            inputName = argv[i];
+        }
+    }
+
+    if (inputName == NULL) {
+        fprintf(stderr, "Usage: Assembler [-s|--symbols] [--stats] [--scanner " SIMD_BACKEND_NAMES "] " MEMORY_MAP_USAGE " [FILE]\n");
         return 1;
     }    
+    if (!validateMemoryMap(&memoryMap)) {
+        return 1;
+    }
 
-    size_t inputLen = strlen(argv[1]);
-    char * fileName = malloc(inputLen + 1);
+    size_t inputLen = strlen(inputName);
+    char * fileName = countedMalloc(inputLen + 1);
     if (fileName == NULL) {
         fprintf(stderr, "Error: Memory allocation failed\n");
         return 1;
     }
     
-    strcpy(fileName, argv[1]);
+    strcpy(fileName, inputName);
 
     char * extension = strrchr(fileName, '.');
     if (extension == NULL || strcmp(extension, ".asm") != 0) {
@@ -47,85 +220,143 @@ int main(int argc, char * argv[]) {
         return 1;
     }
 
-    size_t newLen = (extension - fileName) + 6;
+    size_t baseLen = extension - fileName;
+    size_t newLen = baseLen + 6;
     char * newFileName = realloc(fileName, newLen);
     if (newFileName == NULL) {
         fprintf(stderr, "Error: Memory allocation failed\n");
         free(fileName);
         return 1;
     }
+    extension = newFileName + baseLen;
     fileName = newFileName;
     strcpy(extension, ".hack");
 
-    FILE * inputFile = fopen(argv[1], "r");
-    if (inputFile == NULL) {
-        perror("fopen failed");
+    Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    double phaseStart = currentSeconds();
+
+    // Read: Load the whole input and index its instruction lines once for both passes
+    setLineScannerAllocator(countedRealloc);
+    size_t inputSize;
+    char * input = readSourceFile(inputName, &inputSize);
+    LineIndex lines = {0};
+    if (input == NULL || !buildLineIndex(&lines, input, inputSize)) {
+        free(input);
+        freeLineIndex(&lines);
+        free(fileName);
         return 1;
     }
+    stats.lines = lines.totalLines;
+    stats.scanBackend = lineScannerBackend();
 
     FILE * outputFile = fopen(fileName, "w");
     if (!outputFile) {
         perror("fopen output failed");
-        fclose(inputFile);
+        free(input);
+        freeLineIndex(&lines);
+        free(fileName);
+        return 1;
+    }
+
+    char * output = NULL;
+    size_t outputSize = 0;
+    FILE * codeFile = open_memstream(&output, &outputSize);
+    if (codeFile == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(outputFile);
+        free(input);
+        freeLineIndex(&lines);
+        free(fileName);
         return 1;
     }
 
     SymbolTable symbolTable;
     initSymbolTable(&symbolTable);
+    symbolTable.ramAddress = memoryMap.staticBase;
+    double now = currentSeconds();
+    stats.phaseSeconds[PHASE_READ] = now - phaseStart;
+    phaseStart = now;
     
-    // First Pass: Build Symbol Table
-    char currLine[MAX_LINE_LENGTH];
-    while(fgets(currLine, sizeof(currLine), inputFile)) {
-        char * trimmed = removeWhitespace(currLine);
-        if (trimmed == NULL) {
-            continue;
-        }
-
-        int commandType = getCommandType(trimmed);
-        if (commandType == L_COMMAND) {
-            char * symbol = getSymbol(trimmed);
-            addEntry(&symbolTable, symbol, symbolTable.romAddress);
-        } else if (commandType == A_COMMAND || commandType == C_COMMAND) {
-            symbolTable.romAddress++;
-        } else {
-            fprintf(stderr, "Error: Unknown command type\n");
-            fclose(inputFile);
+    // First Pass: Build Symbol Table, repeated while long label references move labels
+    bool changed;
+    bool firstIteration = true;
+    do {
+        stats.firstPasses++;
+        if (firstPass(input, &lines, &symbolTable, &changed) != 0) {
+            fclose(codeFile);
+            free(output);
             fclose(outputFile);
             cleanupSymbolTable(&symbolTable);
+            free(input);
+            freeLineIndex(&lines);
+            free(fileName);
             return 1;
         }
-    }
+        changed |= firstIteration && symbolTable.romAddress > MAX_SHORT_ADDRESS;
+        firstIteration = false;
+    } while (changed);
+    uint16_t labelCount = symbolTable.size - PREDEFINED_SYMBOLS;
+    now = currentSeconds();
+    stats.phaseSeconds[PHASE_FIRST_PASS] = now - phaseStart;
+    phaseStart = now;
 
     // Second Pass: Generate Code
-    rewind(inputFile);
+    char currLine[MAX_LINE_LENGTH];
     const char * toWrite;
 
-    while (fgets(currLine, sizeof(currLine), inputFile)) {
-        char * trimmed = removeWhitespace(currLine);
-        if (trimmed == NULL) {
-            continue;
-        }
+    for (size_t i = 0; i < lines.count; i++) {
+        char * trimmed = loadInstruction(input, &lines.lines[i], currLine);
 
         int commandType = getCommandType(trimmed);
 
         if (commandType == A_COMMAND) {
             char * symbol = getSymbol(trimmed);
+            uint16_t value;
 
-            if (isNumber(symbol)) {
-                toWrite = convertAddress(symbol);
+            if (parseConstant(symbol, &value)) {
+                stats.numericAddresses++;
+                const char * fixup;
+                toWrite = convertConstant(value, &fixup);
+                if (fixup != NULL) {
+                    stats.longAddresses++;
+                    fprintf(codeFile, "%s\n", toWrite);
+                    toWrite = fixup;
+                }
                 free(symbol);
             } else {
+                stats.symbolicAddresses++;
                 if (!contains(&symbolTable, symbol)) {
+                    if (symbolTable.ramAddress > memoryMap.staticLimit) {
+                        fprintf(stderr, "Error: Variable %s does not fit in the static region %u:%u\n",
+                                symbol, memoryMap.staticBase, memoryMap.staticLimit);
+                        free(symbol);
+                        fclose(codeFile);
+                        free(output);
+                        fclose(outputFile);
+                        cleanupSymbolTable(&symbolTable);
+                        free(input);
+                        freeLineIndex(&lines);
+                        free(fileName);
+                        return 1;
+                    }
                     addEntry(&symbolTable, symbol, symbolTable.ramAddress);
                     symbolTable.ramAddress++;
                 }
                 uint16_t address = getAddress(&symbolTable, symbol);
+                bool isLong = address > MAX_SHORT_ADDRESS;
                 char buffer[6];
-                snprintf(buffer, sizeof(buffer), "%u", address);
+                snprintf(buffer, sizeof(buffer), "%u", isLong ? (uint16_t) ~address : address);
                 toWrite = convertAddress(buffer);
+                if (isLong) {
+                    stats.longAddresses++;
+                    fprintf(codeFile, "%s\n", toWrite);
+                    toWrite = LONG_ADDRESS_FIXUP;
+                }
                 free(symbol);
             }
         } else if (commandType == C_COMMAND) {
+            stats.computations++;
             char * dest = getDest(trimmed);
             char * comp = getComp(trimmed);
             char * jump = getJump(trimmed); 
@@ -137,21 +368,52 @@ int main(int argc, char * argv[]) {
             toWrite = binary;
             freeParserStrings(NULL, dest, comp, jump);
         } else if (commandType == L_COMMAND) {
+            stats.labels++;
             continue;
         } else {
             fprintf(stderr, "Error: Unknown command type\n");
-            fclose(inputFile);
+            fclose(codeFile);
+            free(output);
             fclose(outputFile);
             cleanupSymbolTable(&symbolTable);
+            free(input);
+            freeLineIndex(&lines);
+            free(fileName);
             return 1;
         }
 
-        fprintf(outputFile, "%s\n", toWrite);
+        fprintf(codeFile, "%s\n", toWrite);
+    }
+    fclose(codeFile);
+    free(input);
+    freeLineIndex(&lines);
+    now = currentSeconds();
+    stats.phaseSeconds[PHASE_SECOND_PASS] = now - phaseStart;
+    phaseStart = now;
+
+    // Write: Store the generated code and the optional symbol file
+    int status = 0;
+    if (fwrite(output, 1, outputSize, outputFile) != outputSize) {
+        perror("fwrite output failed");
+        status = 1;
+    }
+    stats.bytesWritten = outputSize;
+    if (fclose(outputFile) != 0) {
+        status = 1;
+    }
+    free(output);
+
+    if (symbolsRequested && status == 0) {
+        strcpy(extension, ".sym");
+        status = writeSymbols(&symbolTable, labelCount, &memoryMap, fileName, &stats.bytesWritten);
+    }
+    stats.phaseSeconds[PHASE_WRITE] = currentSeconds() - phaseStart;
+
+    if (statsRequested) {
+        printStats(&stats, &symbolTable, labelCount, stderr);
     }
 
-    fclose(inputFile);
-    fclose(outputFile);
     cleanupSymbolTable(&symbolTable);
     free(fileName);
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
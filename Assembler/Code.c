@@ -38,6 +38,41 @@ const char * convertAddress(const char * address) {
     return binary;
 }
 
+/**
+ * @brief Returns the number of instructions convertConstant uses for a value
+ * 
+ * @param value The 16-bit constant
+ * @return 1 or 2
+ */
+int constantWords(uint16_t value) {
+    return (value <= MAX_SHORT_ADDRESS || value == 0xFFFF) ? 1 : 2;
+}
+
+/**
+ * @brief Converts a constant to the shortest sequence loading it into A
+ * 
+ * Values up to 32767 fit an A-command and -1 is the C-command A=-1. Any
+ * other value with the high bit set needs two instructions: its complement
+ * is loaded by an A-command and restored by A=!A (LONG_ADDRESS_FIXUP). Only
+ * A is written, as by a plain A-command.
+ * 
+ * @param value The 16-bit constant
+ * @param fixup Receives the second instruction, or NULL if one suffices
+ * @return Pointer to a binary string holding the first instruction
+ */
+const char * convertConstant(uint16_t value, const char ** fixup) {
+    char buffer[6];
+    *fixup = NULL;
+    if (value == 0xFFFF) {
+        return LOAD_MINUS_ONE;
+    } else if (value > MAX_SHORT_ADDRESS) {
+        *fixup = LONG_ADDRESS_FIXUP;
+        value = (uint16_t) ~value;
+    }
+    snprintf(buffer, sizeof(buffer), "%u", value);
+    return convertAddress(buffer);
+}
+
 /**
  * @brief Converts destination mnemonic to 3-bit binary code
  * 
@@ -76,6 +111,7 @@ const char * convertDest(const char * dest) {
  * Maps computation mnemonics to their corresponding 7-bit binary
  * representations. The computation field includes the 'a' bit that
  * determines whether to use the A register (a=0) or M register (a=1).
+ * Commutative operations are accepted with their operands in either order.
  * 
  * @param comp Computation mnemonic string (can be NULL)
  * @return Pointer to 7-bit binary string constant
@@ -109,15 +145,15 @@ const char * convertComp(const char * comp) {
         return D_MINUS_1;
     } else if (strcmp(comp, "A-1") == 0) {
         return A_MINUS_1;
-    } else if (strcmp(comp, "D+A") == 0) {
+    } else if (strcmp(comp, "D+A") == 0 || strcmp(comp, "A+D") == 0) {
         return D_PLUS_A;
     } else if (strcmp(comp, "D-A") == 0) {
         return D_MINUS_A;
     } else if (strcmp(comp, "A-D") == 0) {
         return A_MINUS_D;
-    } else if (strcmp(comp, "D&A") == 0) {
+    } else if (strcmp(comp, "D&A") == 0 || strcmp(comp, "A&D") == 0) {
         return D_AND_A;
-    } else if (strcmp(comp, "D|A") == 0) {
+    } else if (strcmp(comp, "D|A") == 0 || strcmp(comp, "A|D") == 0) {
         return D_OR_A;
     } else if (strcmp(comp, "M") == 0) {
         return M_REG;
@@ -129,15 +165,15 @@ const char * convertComp(const char * comp) {
         return M_PLUS_1;
     } else if (strcmp(comp, "M-1") == 0) {
         return M_MINUS_1;
-    } else if (strcmp(comp, "D+M") == 0) {
+    } else if (strcmp(comp, "D+M") == 0 || strcmp(comp, "M+D") == 0) {
         return D_PLUS_M;
     } else if (strcmp(comp, "D-M") == 0) {
         return D_MINUS_M;
     } else if (strcmp(comp, "M-D") == 0) {
         return M_MINUS_D;
-    } else if (strcmp(comp, "D&M") == 0) {
+    } else if (strcmp(comp, "D&M") == 0 || strcmp(comp, "M&D") == 0) {
         return D_AND_M;
-    } else if (strcmp(comp, "D|M") == 0) {
+    } else if (strcmp(comp, "D|M") == 0 || strcmp(comp, "M|D") == 0) {
         return D_OR_M;
     } else {
         return COMP_NULL;
@@ -20,6 +20,23 @@
  */
 const char * convertAddress(const char * address);
 
+/**
+ * @brief Returns the number of instructions convertConstant uses for a value
+ * 
+ * @param value The 16-bit constant
+ * @return 1 or 2
+ */
+int constantWords(uint16_t value);
+
+/**
+ * @brief Converts a constant to the shortest sequence loading it into A
+ * 
+ * @param value The 16-bit constant
+ * @param fixup Receives the second instruction, or NULL if one suffices
+ * @return Pointer to a binary string holding the first instruction
+ */
+const char * convertConstant(uint16_t value, const char ** fixup);
+
 /**
  * @brief Converts destination mnemonic to 3-bit binary code
  * 
@@ -11,6 +11,9 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Expose clock_gettime, fmemopen and open_memstream under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -21,6 +24,21 @@
 // Maximum Lengths
 #define MAX_LINE_LENGTH   256
 
+// Address Ranges
+#define MAX_SHORT_ADDRESS   32767
+#define MAX_ROM_ADDRESS     65535
+
+// Instruction appended to A-commands whose address exceeds MAX_SHORT_ADDRESS:
+// the A-command loads the complement and this C-command (A=!A) restores it
+#define LONG_ADDRESS_FIXUP  "1110110001100000"
+
+// Constants accepted by A-commands beyond the 15-bit range (see convertConstant)
+#define MIN_CONSTANT        -32768
+#define MAX_CONSTANT        65535
+
+// Single instruction (A=-1) standing in for @-1 and @0xFFFF
+#define LOAD_MINUS_ONE      "1110111010100000"
+
 // Command Types
 #define A_COMMAND   -1
 #define C_COMMAND    0
@@ -104,6 +122,9 @@
 #define SCREEN   16384
 #define KBD      24576
 
+// Number of predefined symbols installed by initSymbolTable
+#define PREDEFINED_SYMBOLS  23
+
 /**
  * @brief Symbol structure for linked list implementation
  * 
@@ -128,6 +149,7 @@ typedef struct SymbolTable {
     uint16_t size;
     uint16_t romAddress;
     uint16_t ramAddress;
+    uint64_t probes;            // Symbol names compared by lookups
 } SymbolTable;
 
 #endif
\ No newline at end of file
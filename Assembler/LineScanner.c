@@ -0,0 +1,355 @@
+/**
+ * @file LineScanner.c
+ * @brief Source line index shared by the Hack Assembler and the VM Translator
+ *
+ * Each 64-byte block is turned into three masks with one bit per byte. The
+ * SSE2 and AVX2 code compares four or two vectors against '\n', '/' and
+ * ' ' and gathers the results with movemask; the scalar code builds the
+ * same masks a byte at a time. A "//" is marked at its first slash, which
+ * needs the first byte of the next block. The masks are then consumed a
+ * line at a time: the content of a line is its non-space bits before the
+ * first comment mark, so the lowest and highest of them give the trimmed
+ * slice. The vector paths are compiled with target attributes and only
+ * called after detectSimdBackend confirms the host has them.
+ */
+
+#include "LineScanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define BLOCK_SIZE      64
+#define INITIAL_LINES   1024
+
+/**
+ * @brief Bit masks of one block, bit i describing byte i
+ */
+typedef struct BlockMasks {
+    uint64_t newlines;
+    uint64_t slashes;
+    uint64_t content;           // Bytes above ' '
+} BlockMasks;
+
+/**
+ * @brief The line being scanned
+ */
+typedef struct LineState {
+    int64_t first;              // Offset of its first content byte, -1 if none yet
+    int64_t last;               // Offset of its last content byte
+    uint32_t contentBytes;      // Content bytes before any comment
+    bool commented;             // Whether a comment has started
+} LineState;
+
+typedef void (*MaskFunction)(const char * block, BlockMasks * masks);
+
+static int activeBackend = -1;
+static MaskFunction maskFunction;
+static LineScannerAllocator allocate = realloc;
+
+/**
+ * @brief Builds the masks of a block one byte at a time
+ */
+static void masksScalar(const char * block, BlockMasks * masks) {
+    uint64_t newlines = 0, slashes = 0, content = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        unsigned char c = (unsigned char) block[i];
+        newlines |= (uint64_t) (c == '\n') << i;
+        slashes |= (uint64_t) (c == '/') << i;
+        content |= (uint64_t) (c > ' ') << i;
+    }
+    masks->newlines = newlines;
+    masks->slashes = slashes;
+    masks->content = content;
+}
+
+#ifdef SIMD_X86
+
+/**
+ * @brief Builds the masks of a block from four 16-byte vectors
+ *
+ * A byte is whitespace when its unsigned maximum with ' ' is ' '.
+ */
+__attribute__((target("sse2")))
+static void masksSSE2(const char * block, BlockMasks * masks) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i space = _mm_set1_epi8(' ');
+    uint64_t newlines = 0, slashes = 0, blanks = 0;
+    for (int part = 0; part < 4; part++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (block + 16 * part));
+        newlines |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (16 * part);
+        slashes |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, slash)) << (16 * part);
+        blanks |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, space), space)) << (16 * part);
+    }
+    masks->newlines = newlines;
+    masks->slashes = slashes;
+    masks->content = ~blanks;
+}
+
+/**
+ * @brief Builds the masks of a block from two 32-byte vectors
+ */
+__attribute__((target("avx2")))
+static void masksAVX2(const char * block, BlockMasks * masks) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i space = _mm256_set1_epi8(' ');
+    uint64_t newlines = 0, slashes = 0, blanks = 0;
+    for (int part = 0; part < 2; part++) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *) (block + 32 * part));
+        newlines |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)) << (32 * part);
+        slashes |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, slash)) << (32 * part);
+        blanks |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(bytes, space), space)) << (32 * part);
+    }
+    masks->newlines = newlines;
+    masks->slashes = slashes;
+    masks->content = ~blanks;
+}
+
+#endif
+
+/**
+ * @brief Reads a whole file into memory
+ *
+ * @param path Path of the file to read
+ * @param size Receives the number of bytes read
+ * @return The file contents (not NUL-terminated), or NULL on error
+ */
+char * readSourceFile(const char * path, size_t * size) {
+    FILE * inputFile = fopen(path, "rb");
+    if (inputFile == NULL) {
+        perror("fopen failed");
+        return NULL;
+    }
+
+    size_t capacity = 1 << 16;
+    char * buffer = allocate(NULL, capacity);
+    *size = 0;
+    while (buffer != NULL) {
+        *size += fread(buffer + *size, 1, capacity - *size, inputFile);
+        if (*size < capacity) {
+            break;
+        }
+        capacity *= 2;
+        char * larger = allocate(buffer, capacity);
+        if (larger == NULL) {
+            free(buffer);
+        }
+        buffer = larger;
+    }
+
+    if (buffer == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    } else if (ferror(inputFile)) {
+        perror("fread failed");
+        free(buffer);
+        buffer = NULL;
+    }
+    fclose(inputFile);
+    return buffer;
+}
+
+/**
+ * @brief Records the line just ended if it has content and starts the next
+ *
+ * @return true on success, false on allocation failure
+ */
+static bool endLine(LineIndex * index, LineState * state) {
+    index->totalLines++;
+    if (state->first >= 0) {
+        if (index->count == index->capacity) {
+            size_t capacity = index->capacity ? index->capacity * 2 : INITIAL_LINES;
+            SourceLine * lines = allocate(index->lines, capacity * sizeof(SourceLine));
+            if (lines == NULL) {
+                return false;
+            }
+            index->lines = lines;
+            index->capacity = capacity;
+        }
+        SourceLine * line = &index->lines[index->count++];
+        line->start = (uint32_t) state->first;
+        line->length = (uint32_t) (state->last - state->first + 1);
+        line->number = index->totalLines;
+        line->spaced = line->length != state->contentBytes;
+    }
+    state->first = -1;
+    state->contentBytes = 0;
+    state->commented = false;
+    return true;
+}
+
+/**
+ * @brief Consumes the masks of the block at a given offset
+ *
+ * @param comments Bits of the bytes starting a "//" comment
+ * @return true on success, false on allocation failure
+ */
+static bool consumeBlock(LineIndex * index, LineState * state, size_t base, const BlockMasks * masks, uint64_t comments) {
+    unsigned bit = 0;
+    while (bit < BLOCK_SIZE) {
+        uint64_t segment = ~0ULL << bit;
+        uint64_t ends = masks->newlines & segment;
+        unsigned end = ends ? (unsigned) __builtin_ctzll(ends) : BLOCK_SIZE;
+        if (end < BLOCK_SIZE) {
+            segment &= (1ULL << end) - 1;
+        }
+
+        if (!state->commented) {
+            uint64_t comment = comments & segment;
+            if (comment) {
+                segment &= (1ULL << __builtin_ctzll(comment)) - 1;
+                state->commented = true;
+            }
+            uint64_t content = masks->content & segment;
+            if (content) {
+                if (state->first < 0) {
+                    state->first = (int64_t) (base + (size_t) __builtin_ctzll(content));
+                }
+                state->last = (int64_t) (base + 63 - (size_t) __builtin_clzll(content));
+                state->contentBytes += (uint32_t) __builtin_popcountll(content);
+            }
+        }
+
+        if (end == BLOCK_SIZE) {
+            break;
+        }
+        if (!endLine(index, state)) {
+            return false;
+        }
+        bit = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the index of the content lines of a text
+ *
+ * Blocks are scanned in place except the last partial one, which is
+ * copied into a buffer padded with spaces. A final line without a newline
+ * is indexed like any other.
+ *
+ * @param index Pointer to the index, which must be empty
+ * @param text The source text
+ * @param size Size of the text in bytes (below 4 GiB)
+ * @return true on success, false on allocation failure or oversized text
+ */
+bool buildLineIndex(LineIndex * index, const char * text, size_t size) {
+    if (size >= UINT32_MAX) {
+        fprintf(stderr, "Error: Input exceeds 4 GiB\n");
+        return false;
+    }
+    if (activeBackend < 0) {
+        setLineScannerBackend(detectSimdBackend());
+    }
+
+    LineState state = {-1, 0, 0, false};
+    BlockMasks masks;
+    char tail[BLOCK_SIZE];
+    for (size_t base = 0; base < size; base += BLOCK_SIZE) {
+        const char * block = text + base;
+        uint64_t nextSlash = 0;
+        if (size - base >= BLOCK_SIZE) {
+            nextSlash = base + BLOCK_SIZE < size && text[base + BLOCK_SIZE] == '/';
+        } else {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, size - base);
+            block = tail;
+        }
+        maskFunction(block, &masks);
+        uint64_t comments = masks.slashes & ((masks.slashes >> 1) | (nextSlash << 63));
+        if (!consumeBlock(index, &state, base, &masks, comments)) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return false;
+        }
+    }
+
+    if (size > 0 && text[size - 1] != '\n' && !endLine(index, &state)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copies a line slice into a NUL-terminated buffer
+ *
+ * @param text The source text the index was built from
+ * @param line The line to copy
+ * @param buffer Buffer receiving the line
+ * @param bufferSize Size of the buffer
+ * @return true on success, false if the line does not fit
+ */
+bool copySourceLine(const char * text, const SourceLine * line, char * buffer, size_t bufferSize) {
+    if (line->length >= bufferSize) {
+        return false;
+    }
+    memcpy(buffer, text + line->start, line->length);
+    buffer[line->length] = '\0';
+    return true;
+}
+
+/**
+ * @brief Frees the lines of an index and leaves it empty
+ *
+ * @param index Pointer to the index
+ */
+void freeLineIndex(LineIndex * index) {
+    free(index->lines);
+    memset(index, 0, sizeof(LineIndex));
+}
+
+/**
+ * @brief Forces a scanning backend instead of the fastest one
+ *
+ * @param backend SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ * @return true on success, false if the host does not support it
+ */
+bool setLineScannerBackend(int backend) {
+    if (backend < SIMD_SCALAR || backend > detectSimdBackend()) {
+        return false;
+    }
+
+    switch (backend) {
+#ifdef SIMD_X86
+        case SIMD_AVX2:
+            maskFunction = masksAVX2;
+            break;
+        case SIMD_SSE2:
+            maskFunction = masksSSE2;
+            break;
+#endif
+        default:
+            maskFunction = masksScalar;
+            break;
+    }
+    activeBackend = backend;
+    return true;
+}
+
+/**
+ * @brief Returns the backend used for scanning
+ *
+ * @return The forced backend, or else the fastest one the host supports
+ */
+int lineScannerBackend(void) {
+    if (activeBackend < 0) {
+        setLineScannerBackend(detectSimdBackend());
+    }
+    return activeBackend;
+}
+
+/**
+ * @brief Replaces realloc for the file buffers and line arrays
+ *
+ * Memory obtained this way is still released with free.
+ *
+ * @param allocator The allocator to use, or NULL for realloc
+ */
+void setLineScannerAllocator(LineScannerAllocator allocator) {
+    allocate = allocator != NULL ? allocator : realloc;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file LineScanner.h
+ * @brief Source line index shared by the Hack Assembler and the VM Translator
+ *
+ * This header declares a scanner that splits a whole source file into
+ * trimmed line slices in one pass, so the parsers no longer search every
+ * line for "//" and walk it again to strip whitespace. The file is scanned
+ * in 64-byte blocks: each block is reduced to three bit masks (newlines,
+ * starts of "//" comments and non-space bytes), and the masks are consumed
+ * with bit scans to find where each line's content begins and ends. The
+ * masks are computed with SSE2 or AVX2 when the host supports them (chosen
+ * at run time, see SimdBackend.h) and with portable C otherwise. Any byte up
+ * to ' ' counts as whitespace, which covers the tabs and carriage returns of
+ * CRLF files. File buffers and line arrays are allocated through a
+ * realloc-like hook, so tools can count them with their other allocations.
+ * The module only depends on the C library so the VM Translator can link it
+ * from here.
+ */
+
+#ifndef LINESCANNER_H
+#define LINESCANNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SimdBackend.h"
+
+/**
+ * @brief Allocates, grows or frees memory with the semantics of realloc
+ */
+typedef void * (*LineScannerAllocator)(void * memory, size_t size);
+
+/**
+ * @brief A line with content, trimmed of whitespace and comments
+ */
+typedef struct SourceLine {
+    uint32_t start;             // Offset of the first content byte in the text
+    uint32_t length;            // Bytes up to the last content byte before any comment
+    uint32_t number;            // Line number in the file, starting at 1
+    bool spaced;                // Whether whitespace remains inside the slice
+} SourceLine;
+
+/**
+ * @brief The content lines of one source text
+ */
+typedef struct LineIndex {
+    SourceLine * lines;         // Lines with content, in file order
+    size_t count;
+    size_t capacity;
+    uint32_t totalLines;        // Lines in the file, including blank and comment lines
+} LineIndex;
+
+/**
+ * @brief Reads a whole file into memory
+ *
+ * @param path Path of the file to read
+ * @param size Receives the number of bytes read
+ * @return The file contents (not NUL-terminated), or NULL on error
+ */
+char * readSourceFile(const char * path, size_t * size);
+
+/**
+ * @brief Builds the index of the content lines of a text
+ *
+ * @param index Pointer to the index, which must be empty
+ * @param text The source text
+ * @param size Size of the text in bytes (below 4 GiB)
+ * @return true on success, false on allocation failure or oversized text
+ */
+bool buildLineIndex(LineIndex * index, const char * text, size_t size);
+
+/**
+ * @brief Copies a line slice into a NUL-terminated buffer
+ *
+ * @param text The source text the index was built from
+ * @param line The line to copy
+ * @param buffer Buffer receiving the line
+ * @param bufferSize Size of the buffer
+ * @return true on success, false if the line does not fit
+ */
+bool copySourceLine(const char * text, const SourceLine * line, char * buffer, size_t bufferSize);
+
+/**
+ * @brief Frees the lines of an index and leaves it empty
+ *
+ * @param index Pointer to the index
+ */
+void freeLineIndex(LineIndex * index);
+
+/**
+ * @brief Forces a scanning backend instead of the fastest one
+ *
+ * @param backend SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ * @return true on success, false if the host does not support it
+ */
+bool setLineScannerBackend(int backend);
+
+/**
+ * @brief Returns the backend used for scanning
+ *
+ * @return The forced backend, or else the fastest one the host supports
+ */
+int lineScannerBackend(void);
+
+/**
+ * @brief Replaces realloc for the file buffers and line arrays
+ *
+ * @param allocator The allocator to use, or NULL for realloc
+ */
+void setLineScannerAllocator(LineScannerAllocator allocator);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file LineScannerBench.c
+ * @brief Benchmark for the line scanner backends
+ *
+ * Indexes a pseudo-random source text with every backend the host supports,
+ * checks that each finds the same lines as the scalar code and prints the
+ * average indexing speed. The text mixes instructions, labels, "//" and
+ * lone '/' characters, tabs, CRLF line ends and blank lines, so lines and
+ * comments start and end at every offset of the 64-byte blocks.
+ */
+
+#include "Config.h"
+#include "LineScanner.h"
+
+#include <time.h>
+
+// Size of the generated text and indexing runs per measurement
+#define BENCH_BYTES     (4 << 20)
+#define BENCH_RUNS      20
+
+// Texts up to this size are checked at every length
+#define CHECK_BYTES     256
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/**
+ * @brief Fills a buffer with pseudo-random assembly-like text
+ *
+ * @param text Buffer to fill
+ * @param size Size of the buffer
+ */
+static void generateText(char * text, size_t size) {
+    static const char * const pieces[] = {
+        "@SP", "AM=M-1", "D=M", "(LOOP)", "0;JMP", "// comment", "/", "//", " ", "\t", "\r\n", "\n", "\n\n", "x/y"
+    };
+    const size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+    uint32_t seed = 12345;
+    size_t used = 0;
+    while (used < size) {
+        seed = seed * 1103515245u + 12345u;
+        const char * piece = pieces[(seed >> 8) % pieceCount];
+        size_t length = strlen(piece);
+        if (length > size - used) {
+            length = size - used;
+        }
+        memcpy(text + used, piece, length);
+        used += length;
+    }
+}
+
+/**
+ * @brief Checks that two indexes hold the same lines
+ */
+static bool sameIndex(const LineIndex * first, const LineIndex * second) {
+    if (first->count != second->count || first->totalLines != second->totalLines) {
+        return false;
+    }
+    for (size_t i = 0; i < first->count; i++) {
+        const SourceLine * a = &first->lines[i];
+        const SourceLine * b = &second->lines[i];
+        if (a->start != b->start || a->length != b->length || a->number != b->number || a->spaced != b->spaced) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that a backend indexes a text like the scalar code
+ *
+ * @param backend The backend to check
+ * @param text The source text
+ * @param size Size of the text in bytes
+ * @return true if both indexes hold the same lines
+ */
+static bool matchesScalar(int backend, const char * text, size_t size) {
+    LineIndex reference = {0};
+    LineIndex index = {0};
+    setLineScannerBackend(SIMD_SCALAR);
+    bool matches = buildLineIndex(&reference, text, size);
+    setLineScannerBackend(backend);
+    matches = matches && buildLineIndex(&index, text, size) && sameIndex(&reference, &index);
+    freeLineIndex(&reference);
+    freeLineIndex(&index);
+    return matches;
+}
+
+/**
+ * @brief Main entry point for the line scanner benchmark
+ *
+ * @return 0 on success, 1 if a backend disagrees with the scalar code
+ */
+int main(void) {
+    char * text = malloc(BENCH_BYTES);
+    if (text == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+    generateText(text, BENCH_BYTES);
+
+    int status = 0;
+    int best = detectSimdBackend();
+    printf("%-8s %10s\n", "backend", "MB/s");
+    for (int backend = SIMD_SCALAR; backend <= best; backend++) {
+        // Short texts of every length also check the padded last block
+        bool matches = matchesScalar(backend, text, BENCH_BYTES);
+        for (size_t size = 0; size <= CHECK_BYTES && matches; size++) {
+            matches = matchesScalar(backend, text, size);
+        }
+        if (!matches) {
+            printf("%-8s differs from the scalar scan\n", simdBackendName(backend));
+            status = 1;
+            continue;
+        }
+
+        setLineScannerBackend(backend);
+        uint64_t start = now();
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            LineIndex index = {0};
+            if (!buildLineIndex(&index, text, BENCH_BYTES)) {
+                status = 1;
+            }
+            freeLineIndex(&index);
+        }
+        double seconds = (double) (now() - start) / 1e9;
+        printf("%-8s %10.1f\n", simdBackendName(backend), (double) BENCH_BYTES * BENCH_RUNS / seconds / 1e6);
+    }
+
+    free(text);
+    return status;
+}
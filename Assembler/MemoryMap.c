@@ -0,0 +1,138 @@
+/**
+ * @file MemoryMap.c
+ * @brief RAM layout shared by the Hack Assembler and the VM Translator
+ *
+ * This file implements the default layout, the --statics, --stack and
+ * --heap options and the checks applied to a layout before it is used.
+ */
+
+#include "MemoryMap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief A region of the memory map, named for error messages
+ */
+typedef struct Region {
+    const char * name;
+    uint16_t base;
+    uint16_t limit;
+} Region;
+
+/**
+ * @brief Sets a memory map to the default layout
+ *
+ * @param map Pointer to the memory map
+ */
+void initMemoryMap(MemoryMap * map) {
+    map->staticBase = DEFAULT_STATIC_BASE;
+    map->staticLimit = DEFAULT_STATIC_LIMIT;
+    map->stackBase = DEFAULT_STACK_BASE;
+    map->stackLimit = DEFAULT_STACK_LIMIT;
+    map->heapBase = DEFAULT_HEAP_BASE;
+    map->heapLimit = DEFAULT_HEAP_LIMIT;
+}
+
+/**
+ * @brief Parses one decimal address ending at the given terminator
+ *
+ * @param text Text to parse
+ * @param terminator Character expected after the digits
+ * @param address Receives the address
+ * @return Pointer past the terminator, or NULL if the text is not an address
+ */
+static const char * parseAddress(const char * text, char terminator, uint16_t * address) {
+    char * end;
+    if (*text < '0' || *text > '9') {
+        return NULL;
+    }
+    unsigned long value = strtoul(text, &end, 10);
+    if (*end != terminator || value > MEMORY_MAP_LAST) {
+        return NULL;
+    }
+    *address = (uint16_t) value;
+    return end + 1;
+}
+
+/**
+ * @brief Parses a layout option and its BASE:LIMIT value
+ *
+ * @param map Pointer to the memory map receiving the bounds
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param index Index of the option; advanced past its value when consumed
+ * @return 1 if the option was consumed, 0 if it is not a layout option, -1 on error
+ */
+int parseMemoryMapOption(MemoryMap * map, int argc, char * argv[], int * index) {
+    const char * option = argv[*index];
+    uint16_t * base;
+    uint16_t * limit;
+    if (strcmp(option, "--statics") == 0) {
+        base = &map->staticBase;
+        limit = &map->staticLimit;
+    } else if (strcmp(option, "--stack") == 0) {
+        base = &map->stackBase;
+        limit = &map->stackLimit;
+    } else if (strcmp(option, "--heap") == 0) {
+        base = &map->heapBase;
+        limit = &map->heapLimit;
+    } else {
+        return 0;
+    }
+
+    const char * value = *index + 1 < argc ? argv[*index + 1] : "";
+    const char * rest = parseAddress(value, ':', base);
+    if (rest == NULL || parseAddress(rest, '\0', limit) == NULL) {
+        fprintf(stderr, "Error: %s expects BASE:LIMIT with addresses up to %d\n", option, MEMORY_MAP_LAST);
+        return -1;
+    }
+    (*index)++;
+    return 1;
+}
+
+/**
+ * @brief Checks that the regions are in range, large enough and disjoint
+ *
+ * Prints the first problem found to stderr.
+ *
+ * @param map Pointer to the memory map
+ * @return true if the layout is usable, false otherwise
+ */
+bool validateMemoryMap(const MemoryMap * map) {
+    const Region regions[] = {
+        {"static region", map->staticBase, map->staticLimit},
+        {"stack", map->stackBase, map->stackLimit},
+        {"heap", map->heapBase, map->heapLimit}
+    };
+    const int regionCount = sizeof(regions) / sizeof(regions[0]);
+
+    for (int i = 0; i < regionCount; i++) {
+        if (regions[i].base < MEMORY_MAP_FIRST || regions[i].base > regions[i].limit) {
+            fprintf(stderr, "Error: The %s %u:%u must satisfy %d <= BASE <= LIMIT\n",
+                    regions[i].name, regions[i].base, regions[i].limit, MEMORY_MAP_FIRST);
+            return false;
+        }
+    }
+    if (map->stackLimit - map->stackBase + 1 < MIN_STACK_WORDS) {
+        fprintf(stderr, "Error: The stack needs at least %d words\n", MIN_STACK_WORDS);
+        return false;
+    }
+    if (map->heapLimit - map->heapBase + 1 < MIN_HEAP_WORDS) {
+        fprintf(stderr, "Error: The heap needs at least %d words\n", MIN_HEAP_WORDS);
+        return false;
+    }
+
+    for (int i = 0; i < regionCount; i++) {
+        for (int j = i + 1; j < regionCount; j++) {
+            if (regions[i].base <= regions[j].limit && regions[j].base <= regions[i].limit) {
+                fprintf(stderr, "Error: The %s %u:%u overlaps the %s %u:%u\n",
+                        regions[i].name, regions[i].base, regions[i].limit,
+                        regions[j].name, regions[j].base, regions[j].limit);
+                return false;
+            }
+        }
+    }
+    return true;
+}
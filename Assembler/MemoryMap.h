@@ -0,0 +1,81 @@
+/**
+ * @file MemoryMap.h
+ * @brief RAM layout shared by the Hack Assembler and the VM Translator
+ *
+ * This header declares the memory map that splits the data RAM below the
+ * screen into the static region, where the assembler allocates variables,
+ * the stack, whose base the translator's bootstrap loads into SP, and the
+ * heap, whose bounds the bootstrap passes to Sys.init for Memory.init. The
+ * defaults reproduce the standard layout (statics 16-255, stack 256-2047,
+ * heap 2048-16383). Both tools accept the same options, so a program that
+ * trades stack for heap is built by passing one layout to each of them,
+ * and both reject layouts whose regions overlap. The module only depends
+ * on the C library so the VM Translator can link it from here.
+ */
+
+#ifndef MEMORYMAP_H
+#define MEMORYMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default Layout (inclusive bounds)
+#define DEFAULT_STATIC_BASE     16
+#define DEFAULT_STATIC_LIMIT    255
+#define DEFAULT_STACK_BASE      256
+#define DEFAULT_STACK_LIMIT     2047
+#define DEFAULT_HEAP_BASE       2048
+#define DEFAULT_HEAP_LIMIT      16383
+
+// Addresses available to the regions: above the virtual registers, below the screen
+#define MEMORY_MAP_FIRST        16
+#define MEMORY_MAP_LAST         16383
+
+// Smallest usable regions: the bootstrap frame of Sys.init and one free-list block
+#define MIN_STACK_WORDS         7
+#define MIN_HEAP_WORDS          2
+
+// Usage text shared by the tools that accept the layout options
+#define MEMORY_MAP_USAGE        "[--statics B:L] [--stack B:L] [--heap B:L]"
+
+/**
+ * @brief Inclusive bounds of the static region, the stack and the heap
+ */
+typedef struct MemoryMap {
+    uint16_t staticBase;
+    uint16_t staticLimit;
+    uint16_t stackBase;
+    uint16_t stackLimit;
+    uint16_t heapBase;
+    uint16_t heapLimit;
+} MemoryMap;
+
+/**
+ * @brief Sets a memory map to the default layout
+ *
+ * @param map Pointer to the memory map
+ */
+void initMemoryMap(MemoryMap * map);
+
+/**
+ * @brief Parses a layout option and its BASE:LIMIT value
+ *
+ * @param map Pointer to the memory map receiving the bounds
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param index Index of the option; advanced past its value when consumed
+ * @return 1 if the option was consumed, 0 if it is not a layout option, -1 on error
+ */
+int parseMemoryMapOption(MemoryMap * map, int argc, char * argv[], int * index);
+
+/**
+ * @brief Checks that the regions are in range, large enough and disjoint
+ *
+ * Prints the first problem found to stderr.
+ *
+ * @param map Pointer to the memory map
+ * @return true if the layout is usable, false otherwise
+ */
+bool validateMemoryMap(const MemoryMap * map);
+
+#endif
@@ -8,6 +8,7 @@
  */
 
 #include "Parser.h"
+#include "Stats.h"
 
 /**
  * @brief Determines the type of assembly command
@@ -34,21 +35,38 @@ int getCommandType(const char * line) {
 }
 
 /**
- * @brief Checks if a string represents a valid decimal number
+ * @brief Parses the constant of an A-command
  * 
- * Validates whether a string contains only decimal digits and represents
- * a valid integer value.
+ * Accepts decimal numbers, negative decimal numbers and hexadecimal numbers
+ * prefixed with 0x, from -32768 to 65535. Negative values are taken as
+ * 16-bit two's complement, so @-1 and @0xFFFF load the same word. Symbols
+ * cannot start with a digit or a minus sign, so anything else is a symbol.
  * 
- * @param line The string to check for numeric content
- * @return true if the string is a valid number, false otherwise
+ * @param line The A-command operand
+ * @param value Receives the 16-bit value
+ * @return true if the operand is a number, false if it is a symbol
+ * @note Function exits with error if a number is malformed or out of range
  */
-bool isNumber(const char * line) {
-    if (*line == '\0') {
+bool parseConstant(const char * line, uint16_t * value) {
+    bool negative = *line == '-';
+    const char * digits = negative ? line + 1 : line;
+    if (!negative && !isdigit((unsigned char) *digits)) {
         return false;
     }
-    char *end;
-    strtol(line, &end, 10);
-    return *end == '\0';
+
+    int base = 10;
+    if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        base = 16;
+        digits += 2;
+    }
+    char * end;
+    long number = isxdigit((unsigned char) *digits) ? strtol(digits, &end, base) : -1;
+    if (number < 0 || *end != '\0' || number > MAX_CONSTANT || (negative && number > -MIN_CONSTANT)) {
+        fprintf(stderr, "Error: Invalid constant @%s (expected %d to %d)\n", line, MIN_CONSTANT, MAX_CONSTANT);
+        exit(1);
+    }
+    *value = (uint16_t) (negative ? -number : number);
+    return true;
 }
 
 /**
@@ -110,7 +128,7 @@ char * getSymbol(const char * line) {
             length--;
         }
         
-        char * symbol = malloc(length + 1);
+        char * symbol = countedMalloc(length + 1);
         if (symbol == NULL) {
             fprintf(stderr, "Error: Memory allocation failed\n");
             exit(1);
@@ -125,7 +143,7 @@ char * getSymbol(const char * line) {
         if (openParenthesis != NULL && closeParenthesis != NULL && closeParenthesis > openParenthesis) {
             size_t length = (size_t) (closeParenthesis - openParenthesis - 1);
             
-            char * symbol = malloc(length + 1);
+            char * symbol = countedMalloc(length + 1);
             if (symbol == NULL) {
                 fprintf(stderr, "Error: Memory allocation failed\n");
                 exit(1);
@@ -162,7 +180,7 @@ char * getDest(const char * line) {
 
     size_t len = (size_t)(equalSign - line);
     
-    char * dest = malloc(len + 1);
+    char * dest = countedMalloc(len + 1);
     if (dest == NULL) {
         fprintf(stderr, "Error: Memory allocation failed\n");
         exit(1);
@@ -192,7 +210,7 @@ char * getComp(const char * line) {
 
     if (equalSign != NULL && semicolon != NULL) {
         len = (size_t)(semicolon - equalSign - 1);
-        comp = malloc(len + 1);
+        comp = countedMalloc(len + 1);
         if (comp == NULL) {
             fprintf(stderr, "Error: Memory allocation failed\n");
             exit(1);
@@ -201,7 +219,7 @@ char * getComp(const char * line) {
         comp[len] = '\0';
     } else if (equalSign != NULL) {
         len = strlen(equalSign + 1);
-        comp = malloc(len + 1);
+        comp = countedMalloc(len + 1);
         if (comp == NULL) {
             fprintf(stderr, "Error: Memory allocation failed\n");
             exit(1);
@@ -209,7 +227,7 @@ char * getComp(const char * line) {
         strcpy(comp, equalSign + 1);
     } else if (semicolon != NULL) {
         len = (size_t)(semicolon - line);
-        comp = malloc(len + 1);
+        comp = countedMalloc(len + 1);
         if (comp == NULL) {
             fprintf(stderr, "Error: Memory allocation failed\n");
             exit(1);
@@ -218,7 +236,7 @@ char * getComp(const char * line) {
         comp[len] = '\0';
     } else {
         len = strlen(line);
-        comp = malloc(len + 1);
+        comp = countedMalloc(len + 1);
         if (comp == NULL) {
             fprintf(stderr, "Error: Memory allocation failed\n");
             exit(1);
@@ -253,7 +271,7 @@ char * getJump(const char * line) {
         length--;
     }
     
-    char * jump = malloc(length + 1);
+    char * jump = countedMalloc(length + 1);
     if (jump == NULL) {
         fprintf(stderr, "Error: Memory allocation failed\n");
         exit(1);
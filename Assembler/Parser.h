@@ -21,12 +21,13 @@
 int getCommandType(const char * line);
 
 /**
- * @brief Checks if a string represents a valid decimal number
+ * @brief Parses the constant of an A-command
  * 
- * @param line The string to check for numeric content
- * @return true if the string is a valid number, false otherwise
+ * @param line The A-command operand
+ * @param value Receives the 16-bit value
+ * @return true if the operand is a number, false if it is a symbol
  */
-bool isNumber(const char * line);
+bool parseConstant(const char * line, uint16_t * value);
 
 /**
  * @brief Removes whitespace and comments from assembly line
@@ -0,0 +1,59 @@
+/**
+ * @file SimdBackend.c
+ * @brief Host vector instruction set detection shared by the toolchain
+ *
+ * This file implements the CPU feature check with __builtin_cpu_supports,
+ * which is only available to GCC-compatible compilers on x86; other hosts
+ * always get the scalar backend.
+ */
+
+#include "SimdBackend.h"
+
+#include <string.h>
+
+/**
+ * @brief Returns the fastest backend the host supports
+ *
+ * @return SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ */
+int detectSimdBackend(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * @brief Returns the name of a backend
+ *
+ * @param backend The backend
+ * @return "scalar", "sse2" or "avx2"
+ */
+const char * simdBackendName(int backend) {
+    switch (backend) {
+        case SIMD_AVX2: return "avx2";
+        case SIMD_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+/**
+ * @brief Looks up a backend by name
+ *
+ * @param name "scalar", "sse2" or "avx2"
+ * @return The backend, or -1 if the name is unknown
+ */
+int parseSimdBackend(const char * name) {
+    for (int backend = SIMD_SCALAR; backend <= SIMD_AVX2; backend++) {
+        if (strcmp(name, simdBackendName(backend)) == 0) {
+            return backend;
+        }
+    }
+    return -1;
+}
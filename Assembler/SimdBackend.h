@@ -0,0 +1,54 @@
+/**
+ * @file SimdBackend.h
+ * @brief Host vector instruction set detection shared by the toolchain
+ *
+ * This header declares the run-time CPU feature check and the backend names
+ * used by the modules that keep SSE2 and AVX2 code paths next to portable
+ * C: the line scanner of the Hack Assembler (see LineScanner.h) and the
+ * screen export of the Emulator (see Emulator/Framebuffer.h). Each module
+ * compiles its vector paths with target attributes and installs one of
+ * them through its own set function; this module only tells which
+ * backends the host supports and how they are named. It only depends on
+ * the C library so the VM Translator and the Emulator can link it from
+ * here.
+ */
+
+#ifndef SIMDBACKEND_H
+#define SIMDBACKEND_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#endif
+
+// Backends, ordered so that the host supports every one up to the detected one
+#define SIMD_SCALAR         0
+#define SIMD_SSE2           1
+#define SIMD_AVX2           2
+
+// Usage text shared by the tools that let a backend be forced
+#define SIMD_BACKEND_NAMES  "scalar|sse2|avx2"
+
+/**
+ * @brief Returns the fastest backend the host supports
+ *
+ * @return SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ */
+int detectSimdBackend(void);
+
+/**
+ * @brief Returns the name of a backend
+ *
+ * @param backend The backend
+ * @return "scalar", "sse2" or "avx2"
+ */
+const char * simdBackendName(int backend);
+
+/**
+ * @brief Looks up a backend by name
+ *
+ * @param name "scalar", "sse2" or "avx2"
+ * @return The backend, or -1 if the name is unknown
+ */
+int parseSimdBackend(const char * name);
+
+#endif
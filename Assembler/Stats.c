@@ -0,0 +1,103 @@
+/**
+ * @file Stats.c
+ * @brief Phase timing and work counters for the Hack Assembler
+ *
+ * This file implements the clock, the allocation counter and the report
+ * printed by --stats.
+ */
+
+#include "Stats.h"
+#include "SimdBackend.h"
+
+#include <time.h>
+
+static uint64_t allocations = 0;
+
+/**
+ * @brief Returns a monotonic wall-clock time in seconds
+ *
+ * @return Seconds since an arbitrary starting point
+ */
+double currentSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Allocates memory like malloc and counts the allocation
+ *
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedMalloc(size_t size) {
+    void * memory = malloc(size);
+    if (memory != NULL) {
+        allocations++;
+    }
+    return memory;
+}
+
+/**
+ * @brief Allocates or grows memory like realloc and counts the allocation
+ *
+ * @param memory Block to grow, or NULL for a new one
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedRealloc(void * memory, size_t size) {
+    void * larger = realloc(memory, size);
+    if (larger != NULL) {
+        allocations++;
+    }
+    return larger;
+}
+
+/**
+ * @brief Returns the number of successful countedMalloc and countedRealloc calls
+ *
+ * @return The allocation count
+ */
+uint64_t allocationCount(void) {
+    return allocations;
+}
+
+/**
+ * @brief Prints phase times and counters
+ *
+ * @param stats Pointer to the counters
+ * @param symbolTable Pointer to the final symbol table
+ * @param labelCount Number of labels recorded by the first pass
+ * @param outputFile Stream receiving the report
+ */
+void printStats(const Stats * stats, const SymbolTable * symbolTable, uint16_t labelCount, FILE * outputFile) {
+    static const char * const phaseNames[PHASE_COUNT] = {"read", "first pass", "second pass", "write"};
+    double total = 0;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        total += stats->phaseSeconds[phase];
+    }
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        fprintf(outputFile, "%-12s %10.3f ms %5.1f%%", phaseNames[phase], stats->phaseSeconds[phase] * 1e3,
+                total > 0 ? 100.0 * stats->phaseSeconds[phase] / total : 0.0);
+        if (phase == PHASE_FIRST_PASS) {
+            fprintf(outputFile, "  (%u iterations)", stats->firstPasses);
+        }
+        fputc('\n', outputFile);
+    }
+    fprintf(outputFile, "%-12s %10.3f ms\n", "total", total * 1e3);
+
+    uint64_t instructions = stats->numericAddresses + stats->symbolicAddresses + stats->longAddresses + stats->computations;
+    fprintf(outputFile, "Lines:                %llu (%s scan)\n", (unsigned long long) stats->lines,
+            simdBackendName(stats->scanBackend));
+    fprintf(outputFile, "Instructions:         %llu (A constant %llu, A symbol %llu, long fixups %llu, C %llu)\n",
+            (unsigned long long) instructions, (unsigned long long) stats->numericAddresses,
+            (unsigned long long) stats->symbolicAddresses, (unsigned long long) stats->longAddresses,
+            (unsigned long long) stats->computations);
+    fprintf(outputFile, "Labels:               %llu\n", (unsigned long long) stats->labels);
+    fprintf(outputFile, "Symbols:              %u (%u predefined, %u labels, %u variables)\n",
+            symbolTable->size, PREDEFINED_SYMBOLS, labelCount, symbolTable->size - PREDEFINED_SYMBOLS - labelCount);
+    fprintf(outputFile, "Symbol table probes:  %llu\n", (unsigned long long) symbolTable->probes);
+    fprintf(outputFile, "Heap allocations:     %llu\n", (unsigned long long) allocationCount());
+    fprintf(outputFile, "Bytes written:        %llu\n", (unsigned long long) stats->bytesWritten);
+}
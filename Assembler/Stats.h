@@ -0,0 +1,84 @@
+/**
+ * @file Stats.h
+ * @brief Phase timing and work counters for the Hack Assembler
+ *
+ * This header declares the counters printed by --stats: wall time of the
+ * read, first pass, second pass and write phases, input lines, instructions
+ * by kind, symbols, symbol table probes, heap allocations and output bytes.
+ * Allocations made by the parser and the symbol table go through
+ * countedMalloc, and those of the line scanner through countedRealloc, so
+ * that they can be counted without passing state around.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "Config.h"
+
+// Phases
+#define PHASE_READ          0
+#define PHASE_FIRST_PASS    1
+#define PHASE_SECOND_PASS   2
+#define PHASE_WRITE         3
+#define PHASE_COUNT         4
+
+/**
+ * @brief Counters collected during one assembly
+ */
+typedef struct Stats {
+    double phaseSeconds[PHASE_COUNT];
+    uint32_t firstPasses;       // First-pass iterations (more than one with long label references)
+    uint64_t lines;             // Input lines, including blank and comment lines
+    int scanBackend;            // SIMD backend that indexed the lines
+    uint64_t numericAddresses;  // A-commands with a constant
+    uint64_t symbolicAddresses; // A-commands with a label or variable
+    uint64_t longAddresses;     // A-commands that needed LONG_ADDRESS_FIXUP
+    uint64_t computations;      // C-commands
+    uint64_t labels;            // L-commands
+    uint64_t bytesWritten;      // Bytes of .hack and .sym output
+} Stats;
+
+/**
+ * @brief Returns a monotonic wall-clock time in seconds
+ *
+ * @return Seconds since an arbitrary starting point
+ */
+double currentSeconds(void);
+
+/**
+ * @brief Allocates memory like malloc and counts the allocation
+ *
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedMalloc(size_t size);
+
+/**
+ * @brief Allocates or grows memory like realloc and counts the allocation
+ *
+ * Used as the line scanner's allocator (see setLineScannerAllocator).
+ *
+ * @param memory Block to grow, or NULL for a new one
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedRealloc(void * memory, size_t size);
+
+/**
+ * @brief Returns the number of successful countedMalloc and countedRealloc calls
+ *
+ * @return The allocation count
+ */
+uint64_t allocationCount(void);
+
+/**
+ * @brief Prints phase times and counters
+ *
+ * @param stats Pointer to the counters
+ * @param symbolTable Pointer to the final symbol table
+ * @param labelCount Number of labels recorded by the first pass
+ * @param outputFile Stream receiving the report
+ */
+void printStats(const Stats * stats, const SymbolTable * symbolTable, uint16_t labelCount, FILE * outputFile);
+
+#endif
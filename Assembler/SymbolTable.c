@@ -9,6 +9,7 @@
  */
 
 #include "SymbolTable.h"
+#include "Stats.h"
 
 /**
  * @brief Initializes a symbol table with predefined symbols
@@ -26,6 +27,7 @@ void initSymbolTable(SymbolTable * symbolTable) {
     symbolTable->size = 0;
     symbolTable->romAddress = 0;
     symbolTable->ramAddress = 16;
+    symbolTable->probes = 0;
     addEntry(symbolTable, "SP", 0);
     addEntry(symbolTable, "LCL", 1);
     addEntry(symbolTable, "ARG", 2);
@@ -65,14 +67,14 @@ void initSymbolTable(SymbolTable * symbolTable) {
  */
 void addEntry(SymbolTable * symbolTable, const char * symbol, uint16_t address) {
     if (!contains(symbolTable, symbol)) {
-        Symbol * newSymbol = malloc(sizeof(Symbol));
+        Symbol * newSymbol = countedMalloc(sizeof(Symbol));
         if (newSymbol == NULL) {
             fprintf(stderr, "Error: Memory allocation failed!\n");
             exit(1);
         }
         
         size_t nameLen = strlen(symbol) + 1;
-        newSymbol->name = malloc(nameLen);
+        newSymbol->name = countedMalloc(nameLen);
         if (newSymbol->name == NULL) {
             fprintf(stderr, "Error: Memory allocation failed!\n");
             free(newSymbol);
@@ -107,6 +109,7 @@ void addEntry(SymbolTable * symbolTable, const char * symbol, uint16_t address)
 bool contains(SymbolTable * symbolTable, const char * symbol) {
     Symbol * curr = symbolTable->head;
     while (curr != NULL) {
+        symbolTable->probes++;
         if (strcmp(curr->name, symbol) == 0) {
             return true;
         }
@@ -128,6 +131,7 @@ bool contains(SymbolTable * symbolTable, const char * symbol) {
 uint16_t getAddress(SymbolTable * symbolTable, const char * symbol) {
     Symbol * curr = symbolTable->head;
     while (curr != NULL) {
+        symbolTable->probes++;
         if (strcmp(curr->name, symbol) == 0) {
             return curr->address;
         }
@@ -136,6 +140,31 @@ uint16_t getAddress(SymbolTable * symbolTable, const char * symbol) {
     return 0xFFFF;
 }
 
+/**
+ * @brief Updates the address of an existing symbol
+ * 
+ * Used when label addresses are recomputed between first-pass iterations.
+ * Symbols that are not in the table are left untouched.
+ * 
+ * @param symbolTable Pointer to the symbol table
+ * @param symbol The symbol name to update
+ * @param address The new memory address for the symbol
+ * @return true if the stored address changed, false otherwise
+ */
+bool setAddress(SymbolTable * symbolTable, const char * symbol, uint16_t address) {
+    Symbol * curr = symbolTable->head;
+    while (curr != NULL) {
+        symbolTable->probes++;
+        if (strcmp(curr->name, symbol) == 0) {
+            bool changed = curr->address != address;
+            curr->address = address;
+            return changed;
+        }
+        curr = curr->next;
+    }
+    return false;
+}
+
 /**
  * @brief Frees all memory allocated by the symbol table
  * 
@@ -47,6 +47,16 @@ bool contains(SymbolTable * symbolTable, const char * symbol);
  */
 uint16_t getAddress(SymbolTable * symbolTable, const char * symbol);
 
+/**
+ * @brief Updates the address of an existing symbol
+ * 
+ * @param symbolTable Pointer to the symbol table
+ * @param symbol The symbol name to update
+ * @param address The new memory address for the symbol
+ * @return true if the stored address changed, false otherwise
+ */
+bool setAddress(SymbolTable * symbolTable, const char * symbol, uint16_t address);
+
 /**
  * @brief Frees all memory allocated by the symbol table
  * 
@@ -11,10 +11,38 @@ The engine coordinates between the tokenizer, symbol tables, and VM writer to
 produce semantically correct VM code compatible with the supplied VM emulator.
 """
 
+from Config import UNROLL_MAX_BOUND, UNROLL_MAX_COMMANDS
 from JackTokenizer import JackTokenizer
 from SymbolTables import SymbolTables
 from VMWriter import VMWriter
-from typing import Optional
+from io import StringIO
+from typing import NamedTuple, Optional
+
+
+class CountedLoop(NamedTuple):
+    """
+    A while-loop whose trip count is known at compile time.
+    
+    Attributes:
+        name (str): The local variable counting the iterations
+        start (int): The constant the variable holds before the loop
+        limit (int): The constant the variable is compared against
+        step (int): The constant added at the end of every iteration
+        bodyStart (int): Position of the first token of the body
+        incrementStart (int): Position of the closing increment statement
+        bodyEnd (int): Position of the closing brace of the body
+    """
+    name: str
+    start: int
+    limit: int
+    step: int
+    bodyStart: int
+    incrementStart: int
+    bodyEnd: int
+
+    def tripCount(self) -> int:
+        """Return the number of iterations the loop performs."""
+        return max(0, (self.limit - self.start + self.step - 1) // self.step)
 
 
 class CompilationEngine:
@@ -34,6 +62,7 @@ class CompilationEngine:
         _symbolTables (SymbolTables): Symbol table manager for scoping
         _vmWriter (VMWriter): VM code generator
         _labelCounter (int): Counter for generating unique labels
+        _loopConstants (dict): Values of counters inside fully unrolled copies
         className (str): Name of the class being compiled
     """
     
@@ -49,6 +78,7 @@ class CompilationEngine:
         self._symbolTables = SymbolTables()
         self._vmWriter = VMWriter(outputFile)
         self._labelCounter = 0
+        self._loopConstants = {}
 
     def newLabel(self) -> int:
         """
@@ -372,12 +402,17 @@ class CompilationEngine:
         else:
             raise SyntaxError(f"Expected ';', got '{self._jackTokenizer.currToken}'")
 
-    def compileStatements(self) -> None:
+    def compileStatements(self, stop: Optional[int] = None) -> None:
         """
         Compile a sequence of statements until a non-statement token is seen.
         Delegates to the appropriate compile* method per statement type.
+
+        Args:
+            stop (Optional[int]): Token position at which to stop early, used
+                to leave out the increment of an unrolled loop.
         """
-        while self.isStatement(self._jackTokenizer.currToken):
+        while self.isStatement(self._jackTokenizer.currToken) and \
+                (stop is None or self._jackTokenizer.position() < stop):
             if self._jackTokenizer.currToken == "let":
                 self.compileLet()
             elif self._jackTokenizer.currToken == "if":
@@ -530,7 +565,9 @@ class CompilationEngine:
         
         Handles constants, string construction, keyword constants, variable
         access (including arrays), parenthesized expressions, subroutine calls,
-        and unary operations.
+        and unary operations. Negated and complemented integer constants and
+        true are pushed as negative constants, which the VM translator loads
+        directly instead of computing them with neg or not.
         
         Raises:
             SyntaxError: If the term structure is invalid.
@@ -551,8 +588,7 @@ class CompilationEngine:
             self._jackTokenizer.advance()
         elif self.isKeywordConstant(tokenVal):
             if tokenVal == "true":
-                self._vmWriter.writePush("constant", 0)
-                self._vmWriter.writeArithmetic("not")
+                self._vmWriter.writePush("constant", -1)
             elif tokenVal in ("false", "null"):
                 self._vmWriter.writePush("constant", 0)
             elif tokenVal == "this":
@@ -581,6 +617,9 @@ class CompilationEngine:
             elif nextTok in ("(", "."):
                 self._jackTokenizer.advance()
                 self.compileSubroutineCall(name)
+            elif name in self._loopConstants:
+                self._vmWriter.writePush("constant", self._loopConstants[name])
+                self._jackTokenizer.advance()
             else:
                 segment = self._symbolTables.kindOf(name)
                 index = self._symbolTables.indexOf(name)
@@ -596,6 +635,11 @@ class CompilationEngine:
         elif self.isUnaryOperation(tokenVal):
             op = tokenVal
             self._jackTokenizer.advance()
+            if self._jackTokenizer.tokenType() == "integerConstant":
+                value = int(self._jackTokenizer.currToken)
+                self._vmWriter.writePush("constant", -value if op == "-" else ~value)
+                self._jackTokenizer.advance()
+                return
             self.compileTerm()
             if op == "-":
                 self._vmWriter.writeArithmetic("neg")
@@ -637,12 +681,17 @@ class CompilationEngine:
     def compileWhile(self) -> None:
         """
         Compile a while-statement. Emits labels and conditional jumps
-        to implement the loop semantics.
+        to implement the loop semantics. Counted loops are unrolled when
+        their copies fit the unrolling budget (see compileUnrolledLoop).
 
         Raises:
             SyntaxError: If parentheses/braces are missing or syntax is malformed.
         """
         if self._jackTokenizer.currToken == "while":
+            loop = self.matchCountedLoop()
+            if loop is not None and self.compileUnrolledLoop(loop):
+                return
+
             labelStart = f"WHILE.EXP{self.newLabel()}"
             labelEnd   = f"WHILE.END{self.newLabel()}"
 
@@ -677,6 +726,168 @@ class CompilationEngine:
         else:
             raise SyntaxError(f"Expected 'while', got '{self._jackTokenizer.currToken}'")
 
+    def matchCountedLoop(self) -> Optional[CountedLoop]:
+        """
+        Recognize a counted loop at the current 'while' token.
+        
+        The loop must have the form
+            let i = START; while (i < LIMIT) { ... let i = i + STEP; }
+        where i is a local, START, LIMIT and STEP are constants with STEP
+        positive, the increment is the last statement of the body and no
+        other statement of the body assigns i. The tokens are inspected
+        without being consumed.
+        
+        Returns:
+            Optional[CountedLoop]: The loop, or None if it does not qualify
+        """
+        tokens = self._jackTokenizer
+        here = tokens.position()
+
+        def isNumber(index: int) -> bool:
+            token = tokens.tokenAt(index)
+            return token is not None and token.isdigit()
+
+        name = tokens.tokenAt(here + 2)
+        if tokens.tokenAt(here + 1) != "(" or tokens.tokenAt(here + 3) != "<" or \
+                not isNumber(here + 4) or tokens.tokenAt(here + 5) != ")" or \
+                tokens.tokenAt(here + 6) != "{" or self._symbolTables.kindOf(name) != "local":
+            return None
+        limit = int(tokens.tokenAt(here + 4))
+
+        if isNumber(here - 2) and tokens.tokenAt(here - 3) == "=":
+            start = int(tokens.tokenAt(here - 2))
+            letIndex = here - 5
+        elif isNumber(here - 2) and tokens.tokenAt(here - 3) == "-" and tokens.tokenAt(here - 4) == "=":
+            start = -int(tokens.tokenAt(here - 2))
+            letIndex = here - 6
+        else:
+            return None
+        if tokens.tokenAt(letIndex) != "let" or tokens.tokenAt(letIndex + 1) != name or \
+                tokens.tokenAt(here - 1) != ";":
+            return None
+
+        bodyStart = here + 7
+        bodyEnd = bodyStart
+        depth = 1
+        while depth > 0:
+            token = tokens.tokenAt(bodyEnd)
+            if token is None:
+                return None
+            depth += (token == "{") - (token == "}")
+            bodyEnd += 1
+        bodyEnd -= 1
+
+        incrementStart = bodyEnd - 7
+        increment = [tokens.tokenAt(incrementStart + k) for k in range(7)]
+        if increment[:5] != ["let", name, "=", name, "+"] or increment[6] != ";" or \
+                not isNumber(incrementStart + 5) or int(increment[5]) == 0:
+            return None
+        for index in range(bodyStart, incrementStart):
+            if tokens.tokenAt(index) == "let" and tokens.tokenAt(index + 1) == name:
+                return None
+
+        loop = CountedLoop(name, start, limit, int(increment[5]), bodyStart, incrementStart, bodyEnd)
+        if start < -UNROLL_MAX_BOUND or limit + loop.step > UNROLL_MAX_BOUND or loop.tripCount() == 0:
+            return None
+        return loop
+
+    def measureStatements(self, start: int, stop: int) -> int:
+        """
+        Count the VM commands a range of statements compiles to.
+        
+        The statements are compiled into a scratch buffer and the tokenizer
+        is left at the end of the range.
+        
+        Args:
+            start (int): Position of the first token
+            stop (int): Position at which to stop
+        
+        Returns:
+            int: The number of VM commands emitted
+        """
+        buffer = StringIO()
+        vmWriter = self._vmWriter
+        self._vmWriter = VMWriter(buffer)
+        self._jackTokenizer.seek(start)
+        self.compileStatements(stop)
+        self._vmWriter = vmWriter
+        return buffer.getvalue().count("\n")
+
+    def compileBodyCopy(self, loop: CountedLoop, value: Optional[int]) -> None:
+        """
+        Compile one copy of an unrolled loop body.
+        
+        Args:
+            loop (CountedLoop): The loop being unrolled
+            value (Optional[int]): The counter's value in this copy, which
+                replaces reads of the counter and drops the increment, or
+                None to compile the body and its increment as written
+        """
+        self._jackTokenizer.seek(loop.bodyStart)
+        if value is None:
+            self.compileStatements(loop.bodyEnd)
+            return
+        self._loopConstants[loop.name] = value
+        self.compileStatements(loop.incrementStart)
+        del self._loopConstants[loop.name]
+
+    def compileUnrolledLoop(self, loop: CountedLoop) -> bool:
+        """
+        Compile a counted loop without its per-iteration test where it pays.
+        
+        When every iteration fits within UNROLL_MAX_COMMANDS VM commands, the
+        body is emitted once per iteration with the counter replaced by its
+        value, and the counter is set to its final value afterwards. Otherwise
+        the body and its increment are repeated as many times as the budget
+        allows inside a loop tested at the bottom, and the iterations left
+        over are emitted as constant copies after it. Loops whose body does
+        not fit twice are compiled as written.
+        
+        Args:
+            loop (CountedLoop): The loop at the current 'while' token
+        
+        Returns:
+            bool: True if the loop was compiled, False to compile it as written
+        """
+        here = self._jackTokenizer.position()
+        bodyCommands = max(1, self.measureStatements(loop.bodyStart, loop.incrementStart))
+        trips = loop.tripCount()
+        segment = self._symbolTables.kindOf(loop.name)
+        index = self._symbolTables.indexOf(loop.name)
+
+        if trips * bodyCommands <= UNROLL_MAX_COMMANDS:
+            factor = 0
+        else:
+            factor = UNROLL_MAX_COMMANDS // (bodyCommands + 4)
+            while factor >= 2 and factor * (bodyCommands + 4) + (trips % factor) * bodyCommands > UNROLL_MAX_COMMANDS:
+                factor -= 1
+            if factor < 2:
+                self._jackTokenizer.seek(here)
+                return False
+
+        unrolled = 0
+        if factor > 0:
+            blocks = trips // factor
+            labelStart = f"WHILE.EXP{self.newLabel()}"
+            if blocks > 1:
+                self._vmWriter.writeLabel(labelStart)
+            for _ in range(factor):
+                self.compileBodyCopy(loop, None)
+            if blocks > 1:
+                self._vmWriter.writePush(segment, index)
+                self._vmWriter.writePush("constant", loop.start + blocks * factor * loop.step)
+                self._vmWriter.writeArithmetic("lt")
+                self._vmWriter.writeIf(labelStart)
+            unrolled = blocks * factor
+
+        if unrolled < trips:
+            for trip in range(unrolled, trips):
+                self.compileBodyCopy(loop, loop.start + trip * loop.step)
+            self._vmWriter.writePush("constant", loop.start + trips * loop.step)
+            self._vmWriter.writePop(segment, index)
+        self._jackTokenizer.seek(loop.bodyEnd)
+        self._jackTokenizer.advance()
+        return True
 
     def isBinaryOperation(self, token: Optional[str]) -> bool:
         """Check if a token is a binary operator."""
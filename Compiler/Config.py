@@ -71,4 +71,11 @@ REGEX_SYMBOL: str = r'[{}()[\].,;+\-*/&|<>=~]'
 REGEX_INTEGER: str = r'\b\d+\b'
 REGEX_STRING: str = r'"[^"\n]*"'
 REGEX_IDENTIFIER: str = r'\b[a-zA-Z_][a-zA-Z0-9_]*\b'
-REGEX_ALL: str = f'({REGEX_SYMBOL})|({REGEX_INTEGER})|({REGEX_STRING})|({REGEX_IDENTIFIER})'
\ No newline at end of file
+REGEX_ALL: str = f'({REGEX_SYMBOL})|({REGEX_INTEGER})|({REGEX_STRING})|({REGEX_IDENTIFIER})'
+
+# Loop Unrolling
+# Counted loops are unrolled while the copies of their body stay within this
+# many VM commands; longer loops are unrolled partially or left alone
+UNROLL_MAX_COMMANDS: int = 64
+# Loop bounds are kept within this magnitude so that no comparison overflows
+UNROLL_MAX_BOUND: int = 16383
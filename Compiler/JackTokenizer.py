@@ -194,4 +194,40 @@ class JackTokenizer:
 
 
 
-                
\ No newline at end of file
+                
+
+    def position(self) -> int:
+        """
+        Return the index of the current token.
+        
+        Returns:
+            int: The current position, usable with seek and tokenAt
+        """
+        return self._index
+
+    def seek(self, index: int) -> None:
+        """
+        Move to the token at the given position.
+        
+        Lets the compilation engine parse a range of tokens more than once,
+        as it does when unrolling a loop body.
+        
+        Args:
+            index (int): A position previously returned by position
+        """
+        self._index = index - 1
+        self.advance()
+
+    def tokenAt(self, index: int) -> Optional[str]:
+        """
+        Look at the token at the given position without moving.
+        
+        Args:
+            index (int): The position of the token
+            
+        Returns:
+            Optional[str]: The token, or None if the position is out of range
+        """
+        if 0 <= index < len(self._tokens):
+            return self._tokens[index]
+        return None
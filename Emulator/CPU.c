@@ -0,0 +1,352 @@
+/**
+ * @file CPU.c
+ * @brief Hack CPU execution module for the native Hack Emulator
+ * 
+ * This file implements instruction decoding and execution for the Hack CPU.
+ * cpuRun is the hot loop used for normal execution and keeps the registers
+ * in locals; cpuStep executes one instruction and is used wherever a caller
+ * needs to observe the machine after every instruction.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CPU.h"
+
+// Encoding of "0;JMP", used with a preceding "@self" to detect halt loops
+#define HALT_JUMP   0xEA87
+
+/**
+ * @brief Computes the ALU output of a C-instruction
+ * 
+ * The common computations are decoded directly; any other bit pattern falls
+ * back to the zx/nx/zy/ny/f/no gate model so every encoding behaves as the
+ * hardware would.
+ * 
+ * @param instruction The C-instruction being executed
+ * @param x The D register
+ * @param y The A register or M, selected by the a-bit
+ * @return The 16-bit ALU output
+ */
+static inline uint16_t compute(uint16_t instruction, uint16_t x, uint16_t y) {
+    switch ((instruction >> 6) & 0x3F) {
+        case 0x2A: return 0;
+        case 0x3F: return 1;
+        case 0x3A: return 0xFFFF;
+        case 0x0C: return x;
+        case 0x30: return y;
+        case 0x0D: return ~x;
+        case 0x31: return ~y;
+        case 0x0F: return -x;
+        case 0x33: return -y;
+        case 0x1F: return x + 1;
+        case 0x37: return y + 1;
+        case 0x0E: return x - 1;
+        case 0x32: return y - 1;
+        case 0x02: return x + y;
+        case 0x13: return x - y;
+        case 0x07: return y - x;
+        case 0x00: return x & y;
+        case 0x15: return x | y;
+        default: break;
+    }
+
+    if (instruction & 0x0800) x = 0;
+    if (instruction & 0x0400) x = ~x;
+    if (instruction & 0x0200) y = 0;
+    if (instruction & 0x0100) y = ~y;
+    uint16_t out = (instruction & 0x0080) ? (uint16_t) (x + y) : (uint16_t) (x & y);
+    if (instruction & 0x0040) out = ~out;
+    return out;
+}
+
+/**
+ * @brief Evaluates the jump bits of a C-instruction against the ALU output
+ * 
+ * @param instruction The C-instruction being executed
+ * @param out The ALU output
+ * @return true if the jump is taken
+ */
+static inline bool jumps(uint16_t instruction, uint16_t out) {
+    int16_t value = (int16_t) out;
+    return ((instruction & 0x4) && value < 0) ||
+           ((instruction & 0x2) && value == 0) ||
+           ((instruction & 0x1) && value > 0);
+}
+
+/**
+ * @brief Updates the stack and heap peaks for a RAM write
+ * 
+ * @param peakStack Highest value written to SP so far
+ * @param peakHeap Highest heap address written so far
+ * @param heapBase First heap address
+ * @param heapLimit Last heap address
+ * @param address The address written
+ * @param value The value written
+ */
+static inline void notePeaks(uint16_t * peakStack, uint16_t * peakHeap, uint16_t heapBase, uint16_t heapLimit,
+                             uint16_t address, uint16_t value) {
+    if (address == RAM_SP) {
+        if (value > *peakStack) *peakStack = value;
+    } else if (address >= heapBase && address <= heapLimit && address > *peakHeap) {
+        *peakHeap = address;
+    }
+}
+
+/**
+ * @brief Returns the host wall-clock time in milliseconds
+ */
+static uint64_t hostMillis(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Refreshes the device word about to be read
+ * 
+ * Reading a low word latches the matching high word, so a program that
+ * reads the low word first gets a consistent 32-bit value.
+ * 
+ * @param cpu Pointer to the CPU
+ * @param address The device address being read
+ * @param cycles The cycle count, including the reading instruction
+ */
+static void readDevice(CPU * cpu, uint16_t address, uint64_t cycles) {
+    uint16_t * ram = cpu->ram;
+    if (address == RAM_CYCLES) {
+        ram[RAM_CYCLES] = (uint16_t) cycles;
+        ram[RAM_CYCLES_HIGH] = (uint16_t) (cycles >> 16);
+    } else if (address == RAM_MILLIS) {
+        uint64_t millis = hostMillis() - cpu->clockStart;
+        ram[RAM_MILLIS] = (uint16_t) millis;
+        ram[RAM_MILLIS_HIGH] = (uint16_t) (millis >> 16);
+    } else if (address == RAM_TIMER) {
+        uint64_t left = cpu->timerEnd > cycles ? cpu->timerEnd - cycles : 0;
+        ram[RAM_TIMER] = (uint16_t) ((left + TIMER_TICK_CYCLES - 1) / TIMER_TICK_CYCLES);
+    }
+}
+
+/**
+ * @brief Applies a write to the device page
+ * 
+ * @param cpu Pointer to the CPU
+ * @param address The device address written
+ * @param value The value written
+ * @param cycles The cycle count, including the writing instruction
+ */
+static void writeDevice(CPU * cpu, uint16_t address, uint16_t value, uint64_t cycles) {
+    if (address == RAM_TIMER) {
+        cpu->timerEnd = value ? cycles + (uint64_t) value * TIMER_TICK_CYCLES : 0;
+    }
+}
+
+/**
+ * @brief Allocates ROM, RAM and breakpoint storage and resets the machine
+ * 
+ * @param cpu Pointer to the CPU to initialize
+ * @return true on success, false if allocation failed
+ */
+bool initCPU(CPU * cpu) {
+    cpu->rom = calloc(ROM_SIZE, sizeof(uint16_t));
+    cpu->ram = calloc(RAM_SIZE, sizeof(uint16_t));
+    cpu->breakpoints = calloc(ROM_SIZE, sizeof(uint8_t));
+    cpu->backEdges = NULL;
+    cpu->romLength = 0;
+    cpu->trackPeaks = false;
+    cpu->heapBase = RAM_HEAP;
+    cpu->heapLimit = RAM_SCREEN - 1;
+    cpu->devices = false;
+    if (cpu->rom == NULL || cpu->ram == NULL || cpu->breakpoints == NULL) {
+        cleanupCPU(cpu);
+        return false;
+    }
+    resetCPU(cpu);
+    return true;
+}
+
+/**
+ * @brief Clears RAM, registers, peaks and devices without touching ROM or breakpoints
+ * 
+ * @param cpu Pointer to the CPU to reset
+ */
+void resetCPU(CPU * cpu) {
+    memset(cpu->ram, 0, RAM_SIZE * sizeof(uint16_t));
+    cpu->a = 0;
+    cpu->d = 0;
+    cpu->pc = 0;
+    cpu->cycles = 0;
+    cpu->peakStack = 0;
+    cpu->peakHeap = 0;
+    cpu->timerEnd = 0;
+    cpu->clockStart = hostMillis();
+}
+
+/**
+ * @brief Computes the ALU output of a C-instruction
+ * 
+ * @param instruction The C-instruction
+ * @param x The D register
+ * @param y The A register or M, selected by the a-bit
+ * @return The 16-bit ALU output
+ */
+uint16_t cpuCompute(uint16_t instruction, uint16_t x, uint16_t y) {
+    return compute(instruction, x, y);
+}
+
+/**
+ * @brief Executes a single instruction, ignoring breakpoints
+ * 
+ * @param cpu Pointer to the CPU
+ * @return true if the instruction was a jump back onto itself (halt loop)
+ */
+bool cpuStep(CPU * cpu) {
+    uint16_t pc = cpu->pc;
+    uint16_t instruction = cpu->rom[pc];
+    cpu->cycles++;
+
+    if (!(instruction & 0x8000)) {
+        cpu->a = instruction;
+        cpu->pc = pc + 1;
+        return false;
+    }
+
+    uint16_t address = cpu->a;
+    bool device = cpu->devices && (address & RAM_MASK) > RAM_KBD;
+    if (device && (instruction & 0x1000)) {
+        readDevice(cpu, address & RAM_MASK, cpu->cycles);
+    }
+    uint16_t y = (instruction & 0x1000) ? cpu->ram[address & RAM_MASK] : address;
+    uint16_t out = compute(instruction, cpu->d, y);
+
+    if (instruction & 0x0008) {
+        cpu->ram[address & RAM_MASK] = out;
+        if (cpu->trackPeaks) notePeaks(&cpu->peakStack, &cpu->peakHeap, cpu->heapBase, cpu->heapLimit, address, out);
+        if (device) writeDevice(cpu, address & RAM_MASK, out, cpu->cycles);
+    }
+    if (instruction & 0x0020) cpu->a = out;
+    if (instruction & 0x0010) cpu->d = out;
+
+    if (jumps(instruction, out)) {
+        cpu->pc = address;
+        return instruction == HALT_JUMP && (uint16_t) (address + 1) == pc && cpu->rom[address] == address;
+    }
+    cpu->pc = pc + 1;
+    return false;
+}
+
+/**
+ * @brief Executes instructions until a limit, breakpoint or halt loop is reached
+ * 
+ * The instruction at the current PC always executes, so a run can resume
+ * from a breakpoint without clearing it. When back-edge counting is enabled,
+ * the run also stops on the head of a loop whose back edge has been taken
+ * LOOP_THRESHOLD times.
+ * 
+ * @param cpu Pointer to the CPU
+ * @param limit Cycle count at which to stop (0 for no limit)
+ * @return CPU_LIMIT, CPU_BREAK, CPU_HALT or CPU_LOOP
+ */
+int cpuRun(CPU * cpu, uint64_t limit) {
+    const uint16_t * rom = cpu->rom;
+    const uint8_t * breakpoints = cpu->breakpoints;
+    int16_t * backEdges = cpu->backEdges;
+    uint16_t * ram = cpu->ram;
+    uint16_t a = cpu->a;
+    uint16_t d = cpu->d;
+    uint16_t pc = cpu->pc;
+    uint64_t cycles = cpu->cycles;
+    bool trackPeaks = cpu->trackPeaks;
+    bool devices = cpu->devices;
+    uint16_t peakStack = cpu->peakStack;
+    uint16_t peakHeap = cpu->peakHeap;
+    uint16_t heapBase = cpu->heapBase;
+    uint16_t heapLimit = cpu->heapLimit;
+    uint64_t end = limit ? limit : UINT64_MAX;
+    int result = CPU_LIMIT;
+
+    while (cycles < end) {
+        uint16_t instruction = rom[pc];
+        cycles++;
+
+        if (!(instruction & 0x8000)) {
+            a = instruction;
+            pc++;
+        } else {
+            uint16_t address = a;
+            bool device = devices && (address & RAM_MASK) > RAM_KBD;
+            if (device && (instruction & 0x1000)) {
+                readDevice(cpu, address & RAM_MASK, cycles);
+            }
+            uint16_t y = (instruction & 0x1000) ? ram[address & RAM_MASK] : address;
+            uint16_t out = compute(instruction, d, y);
+
+            if (instruction & 0x0008) {
+                ram[address & RAM_MASK] = out;
+                if (trackPeaks) notePeaks(&peakStack, &peakHeap, heapBase, heapLimit, address, out);
+                if (device) writeDevice(cpu, address & RAM_MASK, out, cycles);
+            }
+            if (instruction & 0x0020) a = out;
+            if (instruction & 0x0010) d = out;
+
+            if (jumps(instruction, out)) {
+                if (instruction == HALT_JUMP && (uint16_t) (address + 1) == pc && rom[address] == address) {
+                    pc = address;
+                    result = CPU_HALT;
+                    break;
+                }
+                if (backEdges != NULL && address <= pc && ++backEdges[address] >= LOOP_THRESHOLD) {
+                    pc = address;
+                    result = CPU_LOOP;
+                    break;
+                }
+                pc = address;
+            } else {
+                pc++;
+            }
+        }
+
+        if (breakpoints[pc]) {
+            result = CPU_BREAK;
+            break;
+        }
+    }
+
+    cpu->a = a;
+    cpu->d = d;
+    cpu->pc = pc;
+    cpu->cycles = cycles;
+    cpu->peakStack = peakStack;
+    cpu->peakHeap = peakHeap;
+    return result;
+}
+
+/**
+ * @brief Allocates the back-edge counters that make cpuRun report hot loops
+ * 
+ * @param cpu Pointer to the CPU
+ * @return true on success, false if allocation failed
+ */
+bool enableLoopCounting(CPU * cpu) {
+    if (cpu->backEdges == NULL) {
+        cpu->backEdges = calloc(ROM_SIZE, sizeof(int16_t));
+    }
+    return cpu->backEdges != NULL;
+}
+
+/**
+ * @brief Frees all memory owned by the CPU
+ * 
+ * @param cpu Pointer to the CPU to clean up
+ */
+void cleanupCPU(CPU * cpu) {
+    free(cpu->rom);
+    free(cpu->ram);
+    free(cpu->breakpoints);
+    free(cpu->backEdges);
+    cpu->rom = NULL;
+    cpu->ram = NULL;
+    cpu->breakpoints = NULL;
+    cpu->backEdges = NULL;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file CPU.h
+ * @brief Hack CPU and memory model for the native Hack Emulator
+ * 
+ * This header declares the machine state of the Hack computer (ROM, RAM and
+ * the A, D and PC registers) together with the instruction execution loop.
+ * An optional device page after KBD gives programs a 32-bit cycle counter,
+ * a host millisecond clock and a one-shot timer counted in cycles. The
+ * standard Hack machine leaves these addresses unused, so the page is only
+ * served when enabled and is otherwise plain RAM.
+ * It only depends on system headers so that other tools (such as the VM
+ * differential checker) can embed the CPU without pulling in the emulator's
+ * configuration.
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Memory Sizes (ROM is extended to 64K words for programs using long label references)
+#define ROM_SIZE        65536
+#define RAM_SIZE        32768
+#define RAM_MASK        (RAM_SIZE - 1)
+
+// Memory Map
+#define RAM_SP          0
+#define RAM_LCL         1
+#define RAM_ARG         2
+#define RAM_THIS        3
+#define RAM_THAT        4
+#define RAM_R13         13
+#define RAM_R14         14
+#define RAM_STATIC      16
+#define RAM_STACK       256
+#define RAM_HEAP        2048
+#define RAM_SCREEN      16384
+#define RAM_KBD         24576
+#define SCREEN_WORDS    8192
+
+// Device Page (served above KBD only when the CPU's devices flag is set)
+#define RAM_CYCLES          24577   // Low word of the cycle count; reading it latches the high word
+#define RAM_CYCLES_HIGH     24578
+#define RAM_MILLIS          24579   // Low word of host milliseconds since reset; reading it latches the high word
+#define RAM_MILLIS_HIGH     24580
+#define RAM_TIMER           24581   // Writing N arms a one-shot timer of N ticks (0 disarms); reads give the ticks left
+#define TIMER_TICK_CYCLES   1000
+
+// Run Results
+#define CPU_LIMIT       0
+#define CPU_BREAK       1
+#define CPU_HALT        2
+#define CPU_LOOP        3
+
+// Taken back edges to the same target before cpuRun reports CPU_LOOP
+#define LOOP_THRESHOLD  16
+
+/**
+ * @brief Complete state of an emulated Hack computer
+ */
+typedef struct CPU {
+    uint16_t * rom;             // Instruction memory (ROM_SIZE words)
+    uint16_t * ram;             // Data memory (RAM_SIZE words)
+    uint8_t * breakpoints;      // One flag per ROM address, checked after each instruction
+    int16_t * backEdges;        // Taken back edges per target address, or NULL to disable loop reports
+    uint32_t romLength;         // Number of instructions loaded
+    uint16_t a;
+    uint16_t d;
+    uint16_t pc;
+    uint64_t cycles;            // Instructions executed since reset
+    bool trackPeaks;            // Record peakStack and peakHeap on every RAM write
+    uint16_t peakStack;         // Highest value written to SP since reset
+    uint16_t peakHeap;          // Highest heap address written since reset, or 0
+    uint16_t heapBase;          // First heap address counted by peakHeap
+    uint16_t heapLimit;         // Last heap address counted by peakHeap
+    bool devices;               // Serve the device page above KBD
+    uint64_t timerEnd;          // Cycle at which the one-shot timer expires, 0 if disarmed
+    uint64_t clockStart;        // Host milliseconds at reset
+} CPU;
+
+/**
+ * @brief Allocates ROM, RAM and breakpoint storage and resets the machine
+ * 
+ * @param cpu Pointer to the CPU to initialize
+ * @return true on success, false if allocation failed
+ */
+bool initCPU(CPU * cpu);
+
+/**
+ * @brief Clears RAM, registers, peaks and devices without touching ROM or breakpoints
+ * 
+ * @param cpu Pointer to the CPU to reset
+ */
+void resetCPU(CPU * cpu);
+
+/**
+ * @brief Computes the ALU output of a C-instruction
+ * 
+ * @param instruction The C-instruction
+ * @param x The D register
+ * @param y The A register or M, selected by the a-bit
+ * @return The 16-bit ALU output
+ */
+uint16_t cpuCompute(uint16_t instruction, uint16_t x, uint16_t y);
+
+/**
+ * @brief Executes a single instruction, ignoring breakpoints
+ * 
+ * @param cpu Pointer to the CPU
+ * @return true if the instruction was a jump back onto itself (halt loop)
+ */
+bool cpuStep(CPU * cpu);
+
+/**
+ * @brief Executes instructions until a limit, breakpoint or halt loop is reached
+ * 
+ * The instruction at the current PC always executes, so a run can resume
+ * from a breakpoint without clearing it. When back-edge counting is enabled,
+ * the run also stops on the head of a loop whose back edge has been taken
+ * LOOP_THRESHOLD times.
+ * 
+ * @param cpu Pointer to the CPU
+ * @param limit Cycle count at which to stop (0 for no limit)
+ * @return CPU_LIMIT, CPU_BREAK, CPU_HALT or CPU_LOOP
+ */
+int cpuRun(CPU * cpu, uint64_t limit);
+
+/**
+ * @brief Allocates the back-edge counters that make cpuRun report hot loops
+ * 
+ * @param cpu Pointer to the CPU
+ * @return true on success, false if allocation failed
+ */
+bool enableLoopCounting(CPU * cpu);
+
+/**
+ * @brief Frees all memory owned by the CPU
+ * 
+ * @param cpu Pointer to the CPU to clean up
+ */
+void cleanupCPU(CPU * cpu);
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file Config.h
+ * @brief Configuration and constants header for the native Hack Emulator
+ * 
+ * This header file defines constants and configuration values used
+ * throughout the emulator. Machine-level constants (memory sizes and the
+ * memory map) live in CPU.h so that the CPU can be reused by other tools.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Maximum Lengths
+#define MAX_LINE_LENGTH     256
+#define MAX_NAME_LENGTH     256
+
+// Instruction Format
+#define INSTRUCTION_WIDTH   16
+
+// Name of the JackOS function whose entry stops the emulator
+#define HALT_FUNCTION       "Sys.halt"
+
+// Name of the JackOS function whose entry is reported as a failed run
+#define ERROR_FUNCTION      "Sys.error"
+
+// Cycle budget for a single native call while verifying HLE routines
+#define HLE_VERIFY_LIMIT    100000000ULL
+
+// Default cycles between profiler samples (prime, so samples do not alias with loops)
+#define PROFILE_INTERVAL    9973
+
+// Default instructions per frame published through shared memory
+#define FRAME_CYCLES        100000
+
+// Trace Recording
+#define TRACE_CHUNK_CYCLES  1000000     // Cycles per trace chunk (the replay seek granularity)
+#define TRACE_FLUSH_SIZE    65536       // Encoded bytes buffered before writing to the trace file
+
+#endif
@@ -0,0 +1,410 @@
+/**
+ * @file Emulator.c
+ * @brief Main implementation file for the native Hack Emulator
+ * 
+ * This file contains the main entry point of the emulator, which loads an
+ * assembled .hack program and runs it on a native model of the Hack CPU.
+ * Execution stops when the program enters Sys.halt (found through the
+ * assembler's symbol file), reaches a loop it can never leave, or runs out
+ * of its cycle budget; a call to Sys.error is reported with its code.
+ * Optionally, calls to hot JackOS routines are replaced by native
+ * implementations (see HLE.h), and loops that only count or wait are
+ * fast-forwarded (see Idle.h). A sampling profiler can record where cycles
+ * are spent (see Profiler.h), the final screen can be saved as an image
+ * (see Framebuffer.h), the RAM can be shared with external viewers (see
+ * SharedMemory.h), the run can be recorded as a compact trace for later
+ * replay (see Trace.h), the peak stack and heap usage can be reported for
+ * benchmarks, measured against the memory map in the symbol file, and a
+ * device page with a cycle counter, a clock and a timer can be served to
+ * the program (see CPU.h).
+ */
+
+#include "Config.h"
+#include "CPU.h"
+#include "Framebuffer.h"
+#include "HLE.h"
+#include "Idle.h"
+#include "Input.h"
+#include "Loader.h"
+#include "Profiler.h"
+#include "SharedMemory.h"
+#include "Trace.h"
+
+/**
+ * @brief Command line options
+ */
+typedef struct Options {
+    const char * programName;
+    const char * symbolName;
+    const char * keysName;
+    const char * keyFunction;
+    const char * profileName;
+    const char * screenshotName;
+    const char * sharedName;
+    const char * traceName;
+    uint64_t cycleLimit;
+    uint64_t profileInterval;
+    uint64_t frameCycles;
+    uint64_t framesPerSecond;
+    bool hle;
+    bool hleVerify;
+    bool fastForward;
+    bool peaks;
+    bool devices;
+    long dumpStart;
+    long dumpEnd;
+} Options;
+
+/**
+ * @brief Prints command line usage
+ */
+static void printUsage(void) {
+    fprintf(stderr,
+            "Usage: Emulator [OPTIONS] FILE.hack\n"
+            "  --symbols FILE       Symbol file written by Assembler -s (default: FILE.sym)\n"
+            "  --cycles N           Stop after N instructions (default: no limit)\n"
+            "  --keys FILE          Keyboard script of \"CYCLE KEY\" lines\n"
+            "  --key-calls NAME     Count the script's times in calls to function NAME instead of cycles\n"
+            "  --hle                Run hot JackOS routines natively\n"
+            "  --hle-verify         Run hot JackOS routines both ways and compare\n"
+            "  --no-fast-forward    Execute counting and waiting loops instruction by instruction\n"
+            "  --profile FILE       Write sampled call stacks to FILE in folded format\n"
+            "  --profile-interval N Cycles between profiler samples (default: %d)\n"
+            "  --screenshot FILE    Save the screen when the run ends (.pam for RGBA, otherwise PGM)\n"
+            "  --shm NAME           Run on RAM in POSIX shared-memory object NAME for external viewers\n"
+            "  --frame-cycles N     Instructions per published frame (default: %d)\n"
+            "  --fps N              Publish at most N frames per second of wall-clock time (default: no pacing)\n"
+            "  --trace FILE         Record a compact execution trace for TraceReplay (no HLE or fast-forward)\n"
+            "  --peaks              Report the peak stack and heap usage (no HLE)\n"
+            "  --devices            Serve the cycle counter, millisecond clock and timer after KBD (no trace)\n"
+            "  --dump A:B           Print RAM[A..B] when the run ends\n", PROFILE_INTERVAL, FRAME_CYCLES);
+}
+
+/**
+ * @brief Parses command line arguments
+ * 
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param options Pointer to the options to fill
+ * @return true on success, false if usage should be printed
+ */
+static bool parseArguments(int argc, char * argv[], Options * options) {
+    memset(options, 0, sizeof(Options));
+    options->fastForward = true;
+    options->profileInterval = PROFILE_INTERVAL;
+    options->frameCycles = FRAME_CYCLES;
+    options->dumpStart = -1;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--symbols") == 0 && hasValue) {
+            options->symbolName = argv[++i];
+        } else if (strcmp(argv[i], "--cycles") == 0 && hasValue) {
+            options->cycleLimit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--keys") == 0 && hasValue) {
+            options->keysName = argv[++i];
+        } else if (strcmp(argv[i], "--key-calls") == 0 && hasValue) {
+            options->keyFunction = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && hasValue) {
+            options->profileName = argv[++i];
+        } else if (strcmp(argv[i], "--profile-interval") == 0 && hasValue) {
+            options->profileInterval = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--screenshot") == 0 && hasValue) {
+            options->screenshotName = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && hasValue) {
+            options->sharedName = argv[++i];
+        } else if (strcmp(argv[i], "--frame-cycles") == 0 && hasValue) {
+            options->frameCycles = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--fps") == 0 && hasValue) {
+            options->framesPerSecond = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            options->traceName = argv[++i];
+        } else if (strcmp(argv[i], "--hle") == 0) {
+            options->hle = true;
+        } else if (strcmp(argv[i], "--hle-verify") == 0) {
+            options->hle = true;
+            options->hleVerify = true;
+        } else if (strcmp(argv[i], "--no-fast-forward") == 0) {
+            options->fastForward = false;
+        } else if (strcmp(argv[i], "--peaks") == 0) {
+            options->peaks = true;
+        } else if (strcmp(argv[i], "--devices") == 0) {
+            options->devices = true;
+        } else if (strcmp(argv[i], "--dump") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%ld:%ld", &options->dumpStart, &options->dumpEnd) != 2 ||
+                options->dumpStart < 0 || options->dumpEnd < options->dumpStart ||
+                options->dumpEnd >= RAM_SIZE) {
+                fprintf(stderr, "Error: Invalid dump range %s\n", argv[i]);
+                return false;
+            }
+        } else if (argv[i][0] == '-' || options->programName != NULL) {
+            return false;
+        } else {
+            options->programName = argv[i];
+        }
+    }
+    if (options->traceName != NULL && options->hle) {
+        fprintf(stderr, "Error: --trace cannot be combined with HLE, whose routines run outside the ROM\n");
+        return false;
+    }
+    if (options->peaks && options->hle) {
+        fprintf(stderr, "Error: --peaks cannot be combined with HLE, whose routines write the heap outside the ROM\n");
+        return false;
+    }
+    if (options->traceName != NULL && options->devices) {
+        fprintf(stderr, "Error: --trace cannot be combined with --devices, whose clock is not replayable\n");
+        return false;
+    }
+    if (options->keyFunction != NULL && options->keysName == NULL) {
+        fprintf(stderr, "Error: --key-calls needs a keyboard script from --keys\n");
+        return false;
+    }
+    if (options->traceName != NULL) {
+        options->fastForward = false;
+    }
+    return options->programName != NULL;
+}
+
+/**
+ * @brief Loads the symbol file named on the command line or next to the program
+ * 
+ * The symbol file is optional unless it was named explicitly or HLE needs it.
+ * 
+ * @param options Parsed command line options
+ * @param symbols Pointer to the symbol list to fill
+ * @return true on success, false on error
+ */
+static bool loadProgramSymbols(const Options * options, Symbols * symbols) {
+    const char * symbolName = options->symbolName;
+    char defaultSymbols[MAX_NAME_LENGTH];
+    if (symbolName == NULL) {
+        const char * extension = strrchr(options->programName, '.');
+        int baseLength = extension ? (int) (extension - options->programName) : (int) strlen(options->programName);
+        snprintf(defaultSymbols, sizeof(defaultSymbols), "%.*s.sym", baseLength, options->programName);
+        FILE * probe = fopen(defaultSymbols, "r");
+        if (probe == NULL) {
+            if (options->hle) {
+                fprintf(stderr, "Error: HLE requires a symbol file (assemble with -s)\n");
+                return false;
+            }
+            return true;
+        }
+        fclose(probe);
+        symbolName = defaultSymbols;
+    }
+    return loadSymbols(symbols, symbolName);
+}
+
+/**
+ * @brief Returns the earlier of two stop cycles, where 0 means no limit
+ */
+static uint64_t earliest(uint64_t first, uint64_t second) {
+    if (first == 0) {
+        return second;
+    }
+    return (second == 0 || first < second) ? first : second;
+}
+
+/**
+ * @brief Main entry point for the native Hack Emulator
+ * 
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return 0 on success, 1 on error or HLE verification mismatch
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    CPU cpu;
+    Symbols symbols;
+    InputScript input = { NULL, 0, 0, false, 0 };
+    HLE hle;
+    Idle idle;
+    Profiler profiler;
+    SharedMemory shared;
+    Trace trace;
+    bool hleReady = false;
+    bool idleReady = false;
+    bool profiling = false;
+    bool sharing = false;
+    bool tracing = false;
+    int status = 1;
+
+    initSymbols(&symbols);
+    if (!initCPU(&cpu)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+    cpu.trackPeaks = options.peaks;
+    cpu.devices = options.devices;
+    if (!loadProgram(&cpu, options.programName) || !loadProgramSymbols(&options, &symbols) ||
+        (options.keysName != NULL && !loadInput(&input, options.keysName))) {
+        goto cleanup;
+    }
+    cpu.heapBase = symbols.layout.heapBase;
+    cpu.heapLimit = symbols.layout.heapLimit;
+
+    if (options.sharedName != NULL &&
+        !(sharing = openSharedMemory(&shared, &cpu, options.sharedName, options.frameCycles, options.framesPerSecond))) {
+        goto cleanup;
+    }
+
+    if (options.traceName != NULL &&
+        !(tracing = startTrace(&trace, &cpu, options.traceName, TRACE_CHUNK_CYCLES))) {
+        goto cleanup;
+    }
+
+    int haltAddress = findSymbol(&symbols, HALT_FUNCTION);
+    if (haltAddress >= 0) {
+        cpu.breakpoints[haltAddress] = 1;
+    }
+    int errorAddress = findSymbol(&symbols, ERROR_FUNCTION);
+    if (errorAddress >= 0) {
+        cpu.breakpoints[errorAddress] = 1;
+    }
+    int keyAddress = -1;
+    if (options.keyFunction != NULL) {
+        keyAddress = findSymbol(&symbols, options.keyFunction);
+        if (keyAddress < 0) {
+            fprintf(stderr, "Error: Function %s not found for --key-calls\n", options.keyFunction);
+            goto cleanup;
+        }
+        cpu.breakpoints[keyAddress] = 1;
+        input.countsCalls = true;
+    }
+    bool failed = false;
+    int16_t errorCode = 0;
+    uint64_t errorCycle = 0;
+    if (options.hle && !(hleReady = initHLE(&hle, &cpu, &symbols, options.hleVerify))) {
+        goto cleanup;
+    }
+    if (options.fastForward && !(idleReady = initIdle(&idle, &cpu))) {
+        goto cleanup;
+    }
+    if (options.profileName != NULL &&
+        !(profiling = startProfiler(&profiler, &symbols, options.profileName, options.profileInterval))) {
+        goto cleanup;
+    }
+
+    int result;
+    applyInput(&input, &cpu);
+    for (;;) {
+        // A viewer may press a key at any time, so with shared memory every frame is a possible input event
+        uint64_t inputCycle = nextInputCycle(&input);
+        if (sharing) {
+            inputCycle = earliest(inputCycle, shared.nextFrame);
+        }
+        uint64_t stopCycle = earliest(options.cycleLimit, inputCycle);
+        uint64_t runLimit = profiling ? earliest(stopCycle, profiler.nextCycle) : stopCycle;
+        result = tracing ? traceRun(&trace, &cpu, runLimit) : cpuRun(&cpu, runLimit);
+        if (result == CPU_LOOP) {
+            result = idleProbe(&idle, &cpu, options.cycleLimit, inputCycle);
+        }
+        if (profiling && cpu.cycles >= profiler.nextCycle) {
+            profilerSample(&profiler, &cpu);
+        }
+        if (sharing && cpu.cycles >= shared.nextFrame) {
+            publishFrame(&shared, &cpu);
+        }
+
+        if (result == CPU_LIMIT) {
+            if (options.cycleLimit && cpu.cycles >= options.cycleLimit) {
+                break;
+            }
+        } else if (result == CPU_BREAK) {
+            if (cpu.pc == haltAddress) {
+                result = CPU_HALT;
+                break;
+            }
+            if (cpu.pc == keyAddress) {
+                countInputCall(&input, &cpu);
+            }
+            if (cpu.pc == errorAddress) {
+                // Sys.error prints its code and halts; remember the first call for the report
+                if (!failed) {
+                    failed = true;
+                    errorCode = (int16_t) cpu.ram[cpu.ram[RAM_ARG] & RAM_MASK];
+                    errorCycle = cpu.cycles;
+                }
+            } else if (hleReady) {
+                hleDispatch(&hle, &cpu);
+            }
+        } else if (result == CPU_HALT) {
+            break;
+        }
+        applyInput(&input, &cpu);
+    }
+
+    if (result == CPU_HALT) {
+        fprintf(stderr, "Halted at PC %u after %llu cycles\n", cpu.pc, (unsigned long long) cpu.cycles);
+    } else {
+        fprintf(stderr, "Stopped at PC %u after %llu cycles (limit)\n", cpu.pc, (unsigned long long) cpu.cycles);
+    }
+    if (failed) {
+        fprintf(stderr, "Sys.error(%d) called after %llu cycles\n", errorCode, (unsigned long long) errorCycle);
+    }
+    if (input.countsCalls) {
+        fprintf(stderr, "Counted %llu calls to %s\n", (unsigned long long) input.calls, options.keyFunction);
+    }
+    if (idleReady && idle.skips > 0) {
+        fprintf(stderr, "Fast-forwarded %llu loops (%llu cycles)\n",
+                (unsigned long long) idle.skips, (unsigned long long) idle.skippedCycles);
+    }
+    if (options.peaks) {
+        fprintf(stderr, "Peak stack %u words, peak heap %u words\n",
+                cpu.peakStack > symbols.layout.stackBase ? cpu.peakStack - symbols.layout.stackBase : 0,
+                cpu.peakHeap > 0 ? cpu.peakHeap - symbols.layout.heapBase + 1 : 0);
+    }
+
+    status = 0;
+    if (tracing) {
+        tracing = false;
+        if (!stopTrace(&trace, &cpu, stderr)) {
+            status = 1;
+        }
+    }
+    if (sharing) {
+        closeSharedMemory(&shared, &cpu, result == CPU_HALT ? SHARED_HALTED : SHARED_STOPPED);
+        sharing = false;
+    }
+    if (profiling) {
+        stopProfiler(&profiler, stderr);
+        profiling = false;
+    }
+    if (hleReady) {
+        reportHLE(&hle, stderr);
+        status = hle.mismatches > 0;
+    }
+    if (options.screenshotName != NULL && !writeScreenshot(cpu.ram + RAM_SCREEN, options.screenshotName)) {
+        status = 1;
+    }
+
+    for (long address = options.dumpStart; options.dumpStart >= 0 && address <= options.dumpEnd; address++) {
+        printf("RAM[%ld] = %d\n", address, (int16_t) cpu.ram[address]);
+    }
+
+cleanup:
+    if (tracing) {
+        stopTrace(&trace, &cpu, NULL);
+    }
+    if (sharing) {
+        closeSharedMemory(&shared, &cpu, SHARED_STOPPED);
+    }
+    if (profiling) {
+        stopProfiler(&profiler, NULL);
+    }
+    if (idleReady) {
+        cleanupIdle(&idle);
+    }
+    if (hleReady) {
+        cleanupHLE(&hle);
+    }
+    cleanupInput(&input);
+    cleanupSymbols(&symbols);
+    cleanupCPU(&cpu);
+    return status;
+}
@@ -0,0 +1,246 @@
+/**
+ * @file Framebuffer.c
+ * @brief Screen export for the native Hack Emulator
+ *
+ * Each screen word becomes 16 pixels. The scalar code expands one bit at a
+ * time; the SSE2 and AVX2 code broadcasts the word's bytes across a vector,
+ * isolates one bit per lane with a mask and compares against zero, which
+ * turns white pixels into all-ones lanes and black pixels into zero lanes in
+ * a handful of instructions. The vector paths are compiled with target
+ * attributes so the rest of the emulator keeps its baseline instruction set,
+ * and are only called after detectSimdBackend confirms the host has them.
+ */
+
+#include "Framebuffer.h"
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Alpha channel of an RGBA pixel stored as a little-endian word
+#define OPAQUE      0xFF000000u
+
+typedef void (*ConvertFunction)(const uint16_t * screen, uint8_t * pixels);
+
+static int activeBackend = -1;
+static ConvertFunction grayFunction;
+static ConvertFunction rgbaFunction;
+
+/**
+ * @brief Expands the screen into gray pixels one bit at a time
+ */
+static void grayScalar(const uint16_t * screen, uint8_t * pixels) {
+    for (int word = 0; word < SCREEN_WORDS; word++) {
+        uint16_t value = screen[word];
+        for (int bit = 0; bit < 16; bit++) {
+            *pixels++ = (uint8_t) (((value >> bit) & 1) - 1);
+        }
+    }
+}
+
+/**
+ * @brief Expands the screen into RGBA pixels one bit at a time
+ */
+static void rgbaScalar(const uint16_t * screen, uint8_t * pixels) {
+    for (int word = 0; word < SCREEN_WORDS; word++) {
+        uint16_t value = screen[word];
+        for (int bit = 0; bit < 16; bit++) {
+            uint8_t gray = (uint8_t) (((value >> bit) & 1) - 1);
+            *pixels++ = gray;
+            *pixels++ = gray;
+            *pixels++ = gray;
+            *pixels++ = 0xFF;
+        }
+    }
+}
+
+#ifdef SIMD_X86
+
+/**
+ * @brief Expands the screen into gray pixels, one word per 16-byte vector
+ */
+__attribute__((target("sse2")))
+static void graySSE2(const uint16_t * screen, uint8_t * pixels) {
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int word = 0; word < SCREEN_WORDS; word++) {
+        // [lo, hi] -> [lo x2, hi x2] -> [lo x4, hi x4] -> [lo x8, hi x8]
+        __m128i value = _mm_cvtsi32_si128(screen[word]);
+        value = _mm_unpacklo_epi8(value, value);
+        value = _mm_unpacklo_epi16(value, value);
+        value = _mm_unpacklo_epi32(value, value);
+        __m128i white = _mm_cmpeq_epi8(_mm_and_si128(value, bits), zero);
+        _mm_storeu_si128((__m128i *) (pixels + word * 16), white);
+    }
+}
+
+/**
+ * @brief Expands the screen into RGBA pixels, four pixels per vector
+ */
+__attribute__((target("sse2")))
+static void rgbaSSE2(const uint16_t * screen, uint8_t * pixels) {
+    const __m128i bits0 = _mm_setr_epi32(0x0001, 0x0002, 0x0004, 0x0008);
+    const __m128i bits1 = _mm_setr_epi32(0x0010, 0x0020, 0x0040, 0x0080);
+    const __m128i bits2 = _mm_setr_epi32(0x0100, 0x0200, 0x0400, 0x0800);
+    const __m128i bits3 = _mm_setr_epi32(0x1000, 0x2000, 0x4000, 0x8000);
+    const __m128i alpha = _mm_set1_epi32((int) OPAQUE);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int word = 0; word < SCREEN_WORDS; word++) {
+        __m128i value = _mm_set1_epi32(screen[word]);
+        __m128i * out = (__m128i *) (pixels + word * 64);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(value, bits0), zero), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(value, bits1), zero), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(value, bits2), zero), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(value, bits3), zero), alpha));
+    }
+}
+
+/**
+ * @brief Expands the screen into gray pixels, eight words per 16-byte load
+ *
+ * The eight words are copied into both 128-bit lanes and each shuffle
+ * spreads two consecutive words over one 32-byte output vector.
+ */
+__attribute__((target("avx2")))
+static void grayAVX2(const uint16_t * screen, uint8_t * pixels) {
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i spread[4];
+    for (int pair = 0; pair < 4; pair++) {
+        char lo0 = (char) (4 * pair), hi0 = (char) (4 * pair + 1);
+        char lo1 = (char) (4 * pair + 2), hi1 = (char) (4 * pair + 3);
+        spread[pair] = _mm256_setr_epi8(lo0, lo0, lo0, lo0, lo0, lo0, lo0, lo0, hi0, hi0, hi0, hi0, hi0, hi0, hi0, hi0,
+                                        lo1, lo1, lo1, lo1, lo1, lo1, lo1, lo1, hi1, hi1, hi1, hi1, hi1, hi1, hi1, hi1);
+    }
+
+    for (int word = 0; word < SCREEN_WORDS; word += 8) {
+        __m256i value = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) (screen + word)));
+        __m256i * out = (__m256i *) (pixels + word * 16);
+        for (int pair = 0; pair < 4; pair++) {
+            __m256i bytes = _mm256_shuffle_epi8(value, spread[pair]);
+            _mm256_storeu_si256(out + pair, _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bits), zero));
+        }
+    }
+}
+
+/**
+ * @brief Expands the screen into RGBA pixels, eight pixels per vector
+ */
+__attribute__((target("avx2")))
+static void rgbaAVX2(const uint16_t * screen, uint8_t * pixels) {
+    const __m256i bits0 = _mm256_setr_epi32(0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080);
+    const __m256i bits1 = _mm256_setr_epi32(0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, 0x8000);
+    const __m256i alpha = _mm256_set1_epi32((int) OPAQUE);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int word = 0; word < SCREEN_WORDS; word++) {
+        __m256i value = _mm256_set1_epi32(screen[word]);
+        __m256i * out = (__m256i *) (pixels + word * 64);
+        _mm256_storeu_si256(out + 0, _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(value, bits0), zero), alpha));
+        _mm256_storeu_si256(out + 1, _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(value, bits1), zero), alpha));
+    }
+}
+
+#endif
+
+/**
+ * @brief Forces a conversion backend (used by the benchmark)
+ *
+ * @param backend SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ * @return true on success, false if the host does not support it
+ */
+bool setFramebufferBackend(int backend) {
+    if (backend < SIMD_SCALAR || backend > detectSimdBackend()) {
+        return false;
+    }
+
+    switch (backend) {
+#ifdef SIMD_X86
+        case SIMD_AVX2:
+            grayFunction = grayAVX2;
+            rgbaFunction = rgbaAVX2;
+            break;
+        case SIMD_SSE2:
+            grayFunction = graySSE2;
+            rgbaFunction = rgbaSSE2;
+            break;
+#endif
+        default:
+            grayFunction = grayScalar;
+            rgbaFunction = rgbaScalar;
+            break;
+    }
+    activeBackend = backend;
+    return true;
+}
+
+/**
+ * @brief Expands the screen into one byte per pixel (black 0, white 255)
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param pixels Output buffer of SCREEN_PIXELS bytes
+ */
+void screenToGray(const uint16_t * screen, uint8_t * pixels) {
+    if (activeBackend < 0) {
+        setFramebufferBackend(detectSimdBackend());
+    }
+    grayFunction(screen, pixels);
+}
+
+/**
+ * @brief Expands the screen into four bytes per pixel in R, G, B, A order
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param pixels Output buffer of 4 * SCREEN_PIXELS bytes
+ */
+void screenToRGBA(const uint16_t * screen, uint8_t * pixels) {
+    if (activeBackend < 0) {
+        setFramebufferBackend(detectSimdBackend());
+    }
+    rgbaFunction(screen, pixels);
+}
+
+/**
+ * @brief Writes the screen to an image file
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param path The output file
+ * @return true on success, false on I/O errors
+ */
+bool writeScreenshot(const uint16_t * screen, const char * path) {
+    const char * extension = strrchr(path, '.');
+    bool rgba = extension != NULL && strcmp(extension, ".pam") == 0;
+    size_t size = rgba ? 4 * (size_t) SCREEN_PIXELS : (size_t) SCREEN_PIXELS;
+
+    uint8_t * pixels = malloc(size);
+    if (pixels == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return false;
+    }
+
+    FILE * file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open screenshot file %s\n", path);
+        free(pixels);
+        return false;
+    }
+
+    if (rgba) {
+        screenToRGBA(screen, pixels);
+        fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    } else {
+        screenToGray(screen, pixels);
+        fprintf(file, "P5\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    bool success = fwrite(pixels, 1, size, file) == size;
+    success = fclose(file) == 0 && success;
+    if (!success) {
+        fprintf(stderr, "Error: Failed to write screenshot file %s\n", path);
+    }
+    free(pixels);
+    return success;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file Framebuffer.h
+ * @brief Screen export for the native Hack Emulator
+ *
+ * The Hack screen is 512x256 one-bit pixels stored in the 8192 words from
+ * RAM[16384], 32 words per row, with the leftmost pixel of each word in its
+ * least significant bit and 1 meaning black. This module expands that
+ * memory into 8-bit grayscale or 32-bit RGBA images. The expansion is
+ * vectorized with SSE2 or AVX2 when the host supports them (chosen at run
+ * time, see the assembler's SimdBackend.h) and falls back to portable C
+ * otherwise.
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "Config.h"
+#include "CPU.h"
+#include "../Assembler/SimdBackend.h"
+
+// Screen Geometry
+#define SCREEN_WIDTH        512
+#define SCREEN_HEIGHT       256
+#define SCREEN_PIXELS       (SCREEN_WIDTH * SCREEN_HEIGHT)
+
+/**
+ * @brief Forces a conversion backend (used by the benchmark)
+ *
+ * @param backend SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ * @return true on success, false if the host does not support it
+ */
+bool setFramebufferBackend(int backend);
+
+/**
+ * @brief Expands the screen into one byte per pixel (black 0, white 255)
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param pixels Output buffer of SCREEN_PIXELS bytes
+ */
+void screenToGray(const uint16_t * screen, uint8_t * pixels);
+
+/**
+ * @brief Expands the screen into four bytes per pixel in R, G, B, A order
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param pixels Output buffer of 4 * SCREEN_PIXELS bytes
+ */
+void screenToRGBA(const uint16_t * screen, uint8_t * pixels);
+
+/**
+ * @brief Writes the screen to an image file
+ *
+ * Files ending in ".pam" are written as RGBA PAM images, anything else as
+ * binary PGM.
+ *
+ * @param screen The SCREEN_WORDS words of screen memory
+ * @param path The output file
+ * @return true on success, false on I/O errors
+ */
+bool writeScreenshot(const uint16_t * screen, const char * path);
+
+#endif
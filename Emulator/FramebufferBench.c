@@ -0,0 +1,103 @@
+/**
+ * @file FramebufferBench.c
+ * @brief Benchmark for the screen export backends
+ *
+ * Converts a pseudo-random screen with every backend the host supports,
+ * checks that each produces the same image as the scalar code and prints
+ * the average cost of one full-frame conversion. At 60 frames per second a
+ * frame has a budget of about 16.7 ms.
+ */
+
+#include "Config.h"
+#include "Framebuffer.h"
+
+#include <time.h>
+
+// Frames converted per measurement
+#define BENCH_FRAMES    2000
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/**
+ * @brief Times one conversion function over BENCH_FRAMES frames
+ *
+ * @param convert The conversion to time
+ * @param screen Screen memory to convert
+ * @param pixels Output buffer
+ * @return Average microseconds per frame
+ */
+static double timeConversion(void (*convert)(const uint16_t *, uint8_t *), uint16_t * screen, uint8_t * pixels) {
+    uint64_t start = now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        screen[frame & (SCREEN_WORDS - 1)] ^= (uint16_t) frame;
+        convert(screen, pixels);
+    }
+    return (double) (now() - start) / BENCH_FRAMES / 1000.0;
+}
+
+/**
+ * @brief Main entry point for the framebuffer benchmark
+ *
+ * @return 0 on success, 1 if a backend disagrees with the scalar code
+ */
+int main(void) {
+    uint16_t * screen = malloc(SCREEN_WORDS * sizeof(uint16_t));
+    uint8_t * expectedGray = malloc(SCREEN_PIXELS);
+    uint8_t * expectedRGBA = malloc(4 * (size_t) SCREEN_PIXELS);
+    uint8_t * pixels = malloc(4 * (size_t) SCREEN_PIXELS);
+    if (screen == NULL || expectedGray == NULL || expectedRGBA == NULL || pixels == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+
+    uint32_t seed = 12345;
+    for (int i = 0; i < SCREEN_WORDS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        screen[i] = (uint16_t) (seed >> 8);
+    }
+
+    setFramebufferBackend(SIMD_SCALAR);
+    screenToGray(screen, expectedGray);
+    screenToRGBA(screen, expectedRGBA);
+
+    int status = 0;
+    int best = detectSimdBackend();
+    printf("%-8s %14s %14s\n", "backend", "gray us/frame", "rgba us/frame");
+    for (int backend = SIMD_SCALAR; backend <= best; backend++) {
+        setFramebufferBackend(backend);
+
+        screenToGray(screen, pixels);
+        bool grayMatches = memcmp(pixels, expectedGray, SCREEN_PIXELS) == 0;
+        screenToRGBA(screen, pixels);
+        bool rgbaMatches = memcmp(pixels, expectedRGBA, 4 * (size_t) SCREEN_PIXELS) == 0;
+        if (!grayMatches || !rgbaMatches) {
+            printf("%-8s differs from the scalar conversion\n", simdBackendName(backend));
+            status = 1;
+            continue;
+        }
+
+        uint16_t * copy = malloc(SCREEN_WORDS * sizeof(uint16_t));
+        if (copy == NULL) {
+            status = 1;
+            break;
+        }
+        memcpy(copy, screen, SCREEN_WORDS * sizeof(uint16_t));
+        double gray = timeConversion(screenToGray, copy, pixels);
+        double rgba = timeConversion(screenToRGBA, copy, pixels);
+        free(copy);
+        printf("%-8s %14.2f %14.2f\n", simdBackendName(backend), gray, rgba);
+    }
+
+    free(screen);
+    free(expectedGray);
+    free(expectedRGBA);
+    free(pixels);
+    return status;
+}
@@ -0,0 +1,461 @@
+/**
+ * @file HLE.c
+ * @brief High-level emulation module for hot JackOS routines
+ * 
+ * Each routine below is a transliteration of the corresponding JackOS
+ * function that operates on emulated RAM with 16-bit wrap-around and the
+ * VM translator's comparison semantics (lt/gt test the sign of x - y), so
+ * results match native execution bit for bit, including on overflow.
+ * A routine may decline a call whose native execution would never return
+ * (for example a corrupted free list); the call then runs natively.
+ */
+
+#include "HLE.h"
+
+/**
+ * @brief Signature shared by all emulated routines
+ */
+typedef bool (* Routine)(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result);
+
+/**
+ * @brief Static description of an emulated routine
+ */
+typedef struct RoutineInfo {
+    const char * name;
+    int numArgs;
+    Routine routine;
+} RoutineInfo;
+
+/**
+ * @brief VM "lt": true if the 16-bit difference x - y is negative
+ */
+static inline bool lessThan(uint16_t x, uint16_t y) {
+    return (int16_t) (uint16_t) (x - y) < 0;
+}
+
+/**
+ * @brief VM "gt": true if the 16-bit difference x - y is positive
+ */
+static inline bool greaterThan(uint16_t x, uint16_t y) {
+    return (int16_t) (uint16_t) (x - y) > 0;
+}
+
+/**
+ * @brief Reads RAM through an unmasked Jack address
+ */
+static inline uint16_t peek(const uint16_t * ram, uint16_t address) {
+    return ram[address & RAM_MASK];
+}
+
+/**
+ * @brief Writes RAM through an unmasked Jack address
+ */
+static inline void poke(uint16_t * ram, uint16_t address, uint16_t value) {
+    ram[address & RAM_MASK] = value;
+}
+
+/**
+ * @brief Math.multiply: shift-and-add on absolute values equals the wrapped product
+ */
+static bool multiply(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    (void) hle;
+    (void) ram;
+    *result = (uint16_t) ((uint32_t) args[0] * args[1]);
+    return true;
+}
+
+/**
+ * @brief Math.divide: repeated subtraction of the largest doubled divisor
+ */
+static bool divide(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    (void) hle;
+    (void) ram;
+    uint16_t remainder = args[0];
+    uint16_t absDenominator = args[1];
+    if (absDenominator == 0) {
+        *result = 0;
+        return true;
+    }
+
+    bool negative = false;
+    if (lessThan(remainder, 0)) { remainder = -remainder; negative = !negative; }
+    if (lessThan(absDenominator, 0)) { absDenominator = -absDenominator; negative = !negative; }
+
+    uint16_t quotient = 0;
+    while (!lessThan(remainder, absDenominator)) {
+        uint16_t scaledDivisor = absDenominator;
+        uint16_t shift = 0;
+        while (!greaterThan(scaledDivisor + scaledDivisor, remainder) && lessThan(shift, 15)) {
+            scaledDivisor += scaledDivisor;
+            shift++;
+        }
+        if (scaledDivisor == 0) {
+            return false;
+        }
+        remainder -= scaledDivisor;
+        quotient += (uint16_t) (1u << shift);
+    }
+
+    *result = negative ? (uint16_t) -quotient : quotient;
+    return true;
+}
+
+/**
+ * @brief Math.sqrt: bit-by-bit search over the 8 low bits of the root
+ */
+static bool squareRoot(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    (void) hle;
+    (void) ram;
+    uint16_t value = args[0];
+    uint16_t root = 0;
+    if (!lessThan(value, 0)) {
+        for (int bitIndex = 7; bitIndex >= 0; bitIndex--) {
+            uint16_t candidate = root + (uint16_t) (1u << bitIndex);
+            uint16_t candidateSquared = (uint16_t) ((uint32_t) candidate * candidate);
+            if (lessThan(candidateSquared, value) || candidateSquared == value) {
+                root = candidate;
+            }
+        }
+    }
+    *result = root;
+    return true;
+}
+
+/**
+ * @brief Memory.alloc: first fit over the address-ordered free list, splitting only if a header fits
+ */
+static bool alloc(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    uint16_t base = ram[hle->memoryRam];
+    uint16_t size = args[0];
+    if (lessThan(size, 1)) {
+        size = 1;
+    }
+    if (lessThan(32765, size)) {
+        *result = 0;
+        return true;
+    }
+    uint16_t need = size + 2;
+    uint16_t prev = 0;
+    uint16_t curr = ram[hle->memoryFreeList];
+
+    for (uint32_t steps = 0; curr != 0; steps++) {
+        if (steps > RAM_SIZE) {
+            return false;
+        }
+        uint16_t blockSize = peek(ram, base + curr);
+        if (!lessThan(blockSize, need)) {
+            uint16_t oldNext = peek(ram, base + curr + 1);
+            uint16_t next = oldNext;
+            bool split = !lessThan(blockSize, need + 2);
+            poke(ram, base + curr, split ? need : blockSize);
+            poke(ram, base + curr + 1, 0);
+            if (split) {
+                uint16_t newStart = curr + need;
+                poke(ram, base + newStart, blockSize - need);
+                poke(ram, base + newStart + 1, oldNext);
+                next = newStart;
+            }
+            if (prev == 0) {
+                ram[hle->memoryFreeList] = next;
+            } else {
+                poke(ram, base + prev + 1, next);
+            }
+            *result = curr + 2;
+            return true;
+        }
+        prev = curr;
+        curr = peek(ram, base + curr + 1);
+    }
+
+    *result = 0;
+    return true;
+}
+
+/**
+ * @brief Memory.deAlloc: address-ordered insertion with coalescing of both neighbours
+ */
+static bool deAlloc(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    uint16_t base = ram[hle->memoryRam];
+    uint16_t block = args[0] - 2;
+    uint16_t size = peek(ram, base + block);
+    uint16_t prev = 0;
+    uint16_t curr = ram[hle->memoryFreeList];
+
+    for (uint32_t steps = 0; curr != 0 && lessThan(curr, block); steps++) {
+        if (steps > RAM_SIZE) {
+            return false;
+        }
+        prev = curr;
+        curr = peek(ram, base + curr + 1);
+    }
+
+    poke(ram, base + block + 1, curr);
+    if (prev == 0) {
+        ram[hle->memoryFreeList] = block;
+    } else {
+        poke(ram, base + prev + 1, block);
+    }
+
+    if (curr != 0 && (uint16_t) (block + size) == curr) {
+        poke(ram, base + block, size + peek(ram, base + curr));
+        poke(ram, base + block + 1, peek(ram, base + curr + 1));
+    }
+
+    if (prev != 0 && (uint16_t) (prev + peek(ram, base + prev)) == block) {
+        poke(ram, base + prev, peek(ram, base + prev) + peek(ram, base + block));
+        poke(ram, base + prev + 1, peek(ram, base + block + 1));
+    }
+
+    *result = 0;
+    return true;
+}
+
+/**
+ * @brief Screen.clearScreen: zero every screen word starting at Screen.base
+ */
+static bool clearScreen(const HLE * hle, uint16_t * ram, const uint16_t * args, uint16_t * result) {
+    (void) args;
+    uint16_t base = ram[hle->screenBase];
+    uint16_t memoryBase = ram[hle->memoryRam];
+    for (uint16_t i = 0; i < SCREEN_WORDS; i++) {
+        poke(ram, memoryBase + base + i, 0);
+    }
+    *result = 0;
+    return true;
+}
+
+static const RoutineInfo routines[HLE_ROUTINES] = {
+    [HLE_MULTIPLY]      = { "Math.multiply", 2, multiply },
+    [HLE_DIVIDE]        = { "Math.divide", 2, divide },
+    [HLE_SQRT]          = { "Math.sqrt", 1, squareRoot },
+    [HLE_ALLOC]         = { "Memory.alloc", 1, alloc },
+    [HLE_DEALLOC]       = { "Memory.deAlloc", 1, deAlloc },
+    [HLE_CLEAR_SCREEN]  = { "Screen.clearScreen", 0, clearScreen },
+};
+
+/**
+ * @brief Performs one emulated call on the given machine state
+ * 
+ * Reads the arguments from the callee's frame, runs the routine and then
+ * replays the effects of the VM "return" sequence: the result is stored at
+ * ARG, SP becomes ARG + 1, THAT/THIS/ARG/LCL are restored from the frame,
+ * R13/R14 hold the frame minus 4 and the return address, A holds the
+ * return address and D the restored LCL, exactly as the translator's
+ * shared return routine leaves them.
+ * 
+ * @param hle Pointer to the HLE state
+ * @param cpu Pointer to the machine state to update
+ * @param id Routine identifier
+ * @return true if the routine completed, false if it declined the call
+ */
+static bool emulate(const HLE * hle, CPU * cpu, int id) {
+    uint16_t * ram = cpu->ram;
+    uint16_t frame = ram[RAM_LCL];
+    uint16_t argBase = ram[RAM_ARG];
+    uint16_t returnAddress = peek(ram, frame - 5);
+
+    uint16_t args[2] = { 0, 0 };
+    for (int i = 0; i < routines[id].numArgs; i++) {
+        args[i] = peek(ram, argBase + i);
+    }
+
+    uint16_t result;
+    if (!routines[id].routine(hle, ram, args, &result)) {
+        return false;
+    }
+
+    poke(ram, argBase, result);
+    ram[RAM_SP] = argBase + 1;
+    ram[RAM_THAT] = peek(ram, frame - 1);
+    ram[RAM_THIS] = peek(ram, frame - 2);
+    ram[RAM_ARG] = peek(ram, frame - 3);
+    ram[RAM_LCL] = peek(ram, frame - 4);
+    ram[RAM_R13] = frame - 4;
+    ram[RAM_R14] = returnAddress;
+    cpu->a = returnAddress;
+    cpu->d = ram[RAM_LCL];
+    cpu->pc = returnAddress;
+    cpu->cycles++;
+    return true;
+}
+
+/**
+ * @brief Compares a region of RAM and reports the first difference
+ * 
+ * @return true if the region is identical
+ */
+static bool compareRegion(const char * name, const uint16_t * native, const uint16_t * emulated,
+                          uint32_t start, uint32_t end) {
+    for (uint32_t address = start; address < end; address++) {
+        if (native[address] != emulated[address]) {
+            fprintf(stderr, "  %s RAM[%u]: native %d, hle %d\n", name, address,
+                    (int16_t) native[address], (int16_t) emulated[address]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Runs a call both through HLE and natively and compares the outcome
+ * 
+ * The HLE side runs on a copy of the machine. The native side runs on the
+ * real machine with breakpoints ignored, so nested calls are native too,
+ * until control reaches the return address with SP = ARG + 1. Compared
+ * state: A, D, PC, the pointer registers, R13/R14, statics and the live
+ * stack below SP, the heap and the memory-mapped I/O. Temp registers and
+ * the dead stack above SP are scratch space and are not compared; it ends
+ * at the stack limit of the program's memory map, or at the deepest SP of
+ * the call when the stack is a task's stack slice in the heap (see
+ * Sys.spawn).
+ * Execution continues from the native result.
+ * 
+ * @param hle Pointer to the HLE state
+ * @param cpu Pointer to the CPU
+ * @param id Routine identifier
+ */
+static void verify(HLE * hle, CPU * cpu, int id) {
+    CPU emulated = *cpu;
+    emulated.ram = hle->snapshot;
+    memcpy(emulated.ram, cpu->ram, RAM_SIZE * sizeof(uint16_t));
+
+    uint16_t argBase = cpu->ram[RAM_ARG];
+    uint16_t returnAddress = peek(cpu->ram, cpu->ram[RAM_LCL] - 5);
+    uint16_t args[2] = { peek(cpu->ram, argBase), peek(cpu->ram, argBase + 1) };
+    bool handled = emulate(hle, &emulated, id);
+
+    uint64_t start = cpu->cycles;
+    uint16_t deepest = cpu->ram[RAM_SP];
+    do {
+        cpuStep(cpu);
+        if (cpu->ram[RAM_SP] > deepest) {
+            deepest = cpu->ram[RAM_SP];
+        }
+    } while ((cpu->pc != returnAddress || cpu->ram[RAM_SP] != (uint16_t) (argBase + 1)) &&
+             cpu->cycles - start < HLE_VERIFY_LIMIT);
+
+    if (!handled) {
+        return;
+    }
+
+    const uint16_t * native = cpu->ram;
+    const uint16_t * copy = emulated.ram;
+    uint32_t sp = native[RAM_SP];
+    uint32_t deadEnd = (sp >= hle->stackBase && sp <= hle->stackLimit) ? hle->stackLimit + 1u : sp;
+    if (deepest > deadEnd) {
+        deadEnd = deepest;
+    }
+    bool match = cpu->a == emulated.a && cpu->d == emulated.d && cpu->pc == emulated.pc;
+    if (!match || !compareRegion("pointer", native, copy, RAM_SP, RAM_THAT + 1) ||
+        !compareRegion("register", native, copy, RAM_R13, RAM_R14 + 1) ||
+        !compareRegion("below SP", native, copy, RAM_STATIC, sp) ||
+        !compareRegion("above stack", native, copy, deadEnd, RAM_KBD + 1)) {
+        hle->mismatches++;
+        fprintf(stderr, "HLE mismatch: %s(", routines[id].name);
+        for (int i = 0; i < routines[id].numArgs; i++) {
+            fprintf(stderr, "%s%d", i ? ", " : "", (int16_t) args[i]);
+        }
+        fprintf(stderr, ") at cycle %llu\n", (unsigned long long) start);
+        if (!match) {
+            fprintf(stderr, "  registers: native A=%u D=%u PC=%u, hle A=%u D=%u PC=%u\n",
+                    cpu->a, cpu->d, cpu->pc, emulated.a, emulated.d, emulated.pc);
+        }
+    }
+}
+
+/**
+ * @brief Resolves routine entries and installs breakpoints on them
+ * 
+ * A routine is only enabled when its entry label and every static it reads
+ * are present in the symbol file.
+ * 
+ * @param hle Pointer to the HLE state to initialize
+ * @param cpu Pointer to the CPU whose breakpoints are set
+ * @param symbols Symbols loaded from the program's .sym file
+ * @param verify true to run verification mode
+ * @return true on success, false if allocation failed
+ */
+bool initHLE(HLE * hle, CPU * cpu, const Symbols * symbols, bool verify) {
+    memset(hle, 0, sizeof(HLE));
+    hle->verify = verify;
+    hle->memoryRam = findStatic(symbols, "Memory", 0);
+    hle->memoryFreeList = findStatic(symbols, "Memory", 1);
+    hle->screenBase = findStatic(symbols, "Screen", 1);
+    hle->stackBase = symbols->layout.stackBase;
+    hle->stackLimit = symbols->layout.stackLimit;
+
+    if (verify) {
+        hle->snapshot = malloc(RAM_SIZE * sizeof(uint16_t));
+        if (hle->snapshot == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return false;
+        }
+    }
+
+    bool hasMemory = hle->memoryRam >= 0 && hle->memoryFreeList >= 0;
+    for (int id = 0; id < HLE_ROUTINES; id++) {
+        hle->entries[id] = findSymbol(symbols, routines[id].name);
+        if ((id == HLE_ALLOC || id == HLE_DEALLOC) && !hasMemory) {
+            hle->entries[id] = -1;
+        }
+        if (id == HLE_CLEAR_SCREEN && (hle->screenBase < 0 || hle->memoryRam < 0)) {
+            hle->entries[id] = -1;
+        }
+        if (hle->entries[id] >= 0) {
+            cpu->breakpoints[hle->entries[id]] = 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Handles a breakpoint if it is the entry of an emulated routine
+ * 
+ * @param hle Pointer to the HLE state
+ * @param cpu Pointer to the CPU
+ * @return true if the call was completed and execution resumed at the return address
+ */
+bool hleDispatch(HLE * hle, CPU * cpu) {
+    for (int id = 0; id < HLE_ROUTINES; id++) {
+        if (hle->entries[id] != cpu->pc) {
+            continue;
+        }
+        hle->calls[id]++;
+        if (hle->verify) {
+            verify(hle, cpu, id);
+            return true;
+        }
+        return emulate(hle, cpu, id);
+    }
+    return false;
+}
+
+/**
+ * @brief Prints per-routine call counts and verification results
+ * 
+ * @param hle Pointer to the HLE state
+ * @param outputFile Stream to print to
+ */
+void reportHLE(const HLE * hle, FILE * outputFile) {
+    for (int id = 0; id < HLE_ROUTINES; id++) {
+        if (hle->entries[id] < 0) {
+            fprintf(outputFile, "HLE %-20s unavailable\n", routines[id].name);
+        } else {
+            fprintf(outputFile, "HLE %-20s %llu calls\n", routines[id].name,
+                    (unsigned long long) hle->calls[id]);
+        }
+    }
+    if (hle->verify) {
+        fprintf(outputFile, "HLE verification: %llu mismatches\n", (unsigned long long) hle->mismatches);
+    }
+}
+
+/**
+ * @brief Frees all memory owned by the HLE state
+ * 
+ * @param hle Pointer to the HLE state to clean up
+ */
+void cleanupHLE(HLE * hle) {
+    free(hle->snapshot);
+    hle->snapshot = NULL;
+}
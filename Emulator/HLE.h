@@ -0,0 +1,83 @@
+/**
+ * @file HLE.h
+ * @brief High-level emulation of hot JackOS routines
+ * 
+ * This header declares the interface used by the emulator to replace calls to
+ * selected JackOS functions (Math.multiply, Math.divide, Math.sqrt,
+ * Memory.alloc, Memory.deAlloc and Screen.clearScreen) with native C
+ * implementations. Routine entry points and the statics they touch are found
+ * through the symbol file written by the assembler. In verification mode every
+ * call runs both natively and through HLE and the two results are compared.
+ */
+
+#ifndef HLE_H
+#define HLE_H
+
+#include "Config.h"
+#include "CPU.h"
+#include "Loader.h"
+
+// Routine Identifiers
+#define HLE_MULTIPLY        0
+#define HLE_DIVIDE          1
+#define HLE_SQRT            2
+#define HLE_ALLOC           3
+#define HLE_DEALLOC         4
+#define HLE_CLEAR_SCREEN    5
+#define HLE_ROUTINES        6
+
+/**
+ * @brief HLE configuration and statistics
+ */
+typedef struct HLE {
+    int entries[HLE_ROUTINES];      // ROM address of each routine, or -1 if unavailable
+    int memoryRam;                  // RAM address of Memory.ram (static 0), or -1
+    int memoryFreeList;             // RAM address of Memory.freeList (static 1), or -1
+    int screenBase;                 // RAM address of Screen.base (static 1), or -1
+    uint16_t stackBase;             // First word of the program's stack
+    uint16_t stackLimit;            // Last word of the stack, where the dead stack ends
+    bool verify;                    // Run every call both ways and compare
+    uint16_t * snapshot;            // Scratch RAM for the HLE side of a verified call
+    uint64_t calls[HLE_ROUTINES];   // Calls handled (or verified) per routine
+    uint64_t mismatches;            // Verified calls whose results differed
+} HLE;
+
+/**
+ * @brief Resolves routine entries and installs breakpoints on them
+ * 
+ * @param hle Pointer to the HLE state to initialize
+ * @param cpu Pointer to the CPU whose breakpoints are set
+ * @param symbols Symbols loaded from the program's .sym file
+ * @param verify true to run verification mode
+ * @return true on success, false if allocation failed
+ */
+bool initHLE(HLE * hle, CPU * cpu, const Symbols * symbols, bool verify);
+
+/**
+ * @brief Handles a breakpoint if it is the entry of an emulated routine
+ * 
+ * Must be called with the CPU stopped on the first instruction of the
+ * function, i.e. directly after the caller's "call" sequence.
+ * 
+ * @param hle Pointer to the HLE state
+ * @param cpu Pointer to the CPU
+ * @return true if the call was completed and execution resumed at the return address
+ */
+bool hleDispatch(HLE * hle, CPU * cpu);
+
+/**
+ * @brief Prints per-routine call counts and verification results
+ * 
+ * @param hle Pointer to the HLE state
+ * @param outputFile Stream to print to
+ */
+void reportHLE(const HLE * hle, FILE * outputFile);
+
+/**
+ * @brief Frees all memory owned by the HLE state
+ * 
+ * @param hle Pointer to the HLE state to clean up
+ */
+void cleanupHLE(HLE * hle);
+
+#endif
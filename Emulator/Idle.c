@@ -0,0 +1,306 @@
+/**
+ * @file Idle.c
+ * @brief Idle-loop detection and fast-forward module for the native Hack Emulator
+ * 
+ * A recorded iteration is a list of executed instructions from the loop head
+ * back to the loop head. Three iterations are compared step by step. The
+ * loop can be skipped when:
+ * - every iteration executes the same instructions;
+ * - every instruction that reads or writes M uses the same address each time;
+ * - every computed value changes by the same amount in each iteration;
+ * - & and | (the only non-affine ALU operations) only see unchanged operands;
+ * - no instruction touches the device page, whose values change on their own.
+ * Under these conditions every value is an affine function of the iteration
+ * number, so the loop behaves the same way until a conditional jump's ALU
+ * output changes sign class, which happens after a computable number of
+ * iterations.
+ */
+
+#include "Idle.h"
+
+// Result of a probe that found nothing to skip
+#define IDLE_GIVE_UP    -1
+
+/**
+ * @brief Tells whether an ALU computation is affine in its operands
+ * 
+ * @param instruction The C-instruction
+ * @return true for constants, copies, negations, increments, sums and differences
+ */
+static bool isAffine(uint16_t instruction) {
+    switch ((instruction >> 6) & 0x3F) {
+        case 0x2A: case 0x3F: case 0x3A: case 0x0C: case 0x30: case 0x0D:
+        case 0x31: case 0x0F: case 0x33: case 0x1F: case 0x37: case 0x0E:
+        case 0x32: case 0x02: case 0x13: case 0x07:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Counts iterations until a value stepping by delta changes sign class
+ * 
+ * Classes are negative, zero and positive as seen by the jump bits. Values
+ * wrap at 16 bits, so a positive value stepping upwards eventually turns
+ * negative.
+ * 
+ * @param value The value in the last recorded iteration
+ * @param delta The per-iteration change (non-zero)
+ * @return The smallest n >= 1 such that value + n * delta is in another class
+ */
+static uint64_t firstChange(uint16_t value, uint16_t delta) {
+    int32_t v = (int16_t) value;
+    int32_t step = (int16_t) delta;
+    if (v == 0) {
+        return 1;
+    }
+    if (step > 0) {
+        return v < 0 ? (uint64_t) ((-v + step - 1) / step) : (uint64_t) ((32767 - v) / step + 1);
+    }
+    step = -step;
+    return v > 0 ? (uint64_t) ((v + step - 1) / step) : (uint64_t) ((v + 32768) / step + 1);
+}
+
+/**
+ * @brief Executes and records one loop iteration starting at the head
+ * 
+ * @param cpu Pointer to the CPU, positioned on the loop head
+ * @param steps Storage for IDLE_MAX_BODY steps
+ * @param stopCycle Cycle at which to stop (0 for no limit)
+ * @param length Set to the number of recorded steps
+ * @return CPU_LOOP when back at the head, CPU_BREAK, CPU_HALT or CPU_LIMIT
+ *         if execution had to stop, or IDLE_GIVE_UP if the body is too long
+ */
+static int recordIteration(CPU * cpu, IdleStep * steps, uint64_t stopCycle, size_t * length) {
+    uint16_t head = cpu->pc;
+    size_t count = 0;
+    do {
+        if (count == IDLE_MAX_BODY) {
+            return IDLE_GIVE_UP;
+        }
+        if (stopCycle && cpu->cycles >= stopCycle) {
+            return CPU_LIMIT;
+        }
+
+        uint16_t instruction = cpu->rom[cpu->pc];
+        IdleStep * step = &steps[count++];
+        step->pc = cpu->pc;
+        step->address = cpu->a;
+        step->x = cpu->d;
+        if (instruction & 0x8000) {
+            step->y = (instruction & 0x1000) ? cpu->ram[cpu->a & RAM_MASK] : cpu->a;
+            step->out = cpuCompute(instruction, step->x, step->y);
+        } else {
+            step->y = 0;
+            step->out = instruction;
+        }
+
+        if (cpuStep(cpu)) {
+            return CPU_HALT;
+        }
+        if (cpu->breakpoints[cpu->pc]) {
+            return CPU_BREAK;
+        }
+    } while (cpu->pc != head);
+
+    *length = count;
+    return CPU_LOOP;
+}
+
+/**
+ * @brief Records three iterations and fast-forwards the loop if it only counts or waits
+ * 
+ * @param idle Pointer to the fast-forward state
+ * @param cpu Pointer to the CPU, stopped on a loop head
+ * @param stopCycle Cycle at which to stop (0 for no limit)
+ * @param inputCycle Cycle of the next KBD change (0 if none is pending)
+ * @return CPU_LOOP to continue, CPU_BREAK, CPU_HALT, CPU_LIMIT, or IDLE_GIVE_UP
+ */
+static int fastForward(Idle * idle, CPU * cpu, uint64_t stopCycle, uint64_t inputCycle) {
+    uint64_t recordStop = stopCycle;
+    if (inputCycle && (recordStop == 0 || inputCycle < recordStop)) {
+        recordStop = inputCycle;
+    }
+
+    uint16_t headA[4];
+    uint16_t headD[4];
+    size_t lengths[3];
+    for (int k = 0; k < 3; k++) {
+        headA[k] = cpu->a;
+        headD[k] = cpu->d;
+        int result = recordIteration(cpu, idle->trace + k * IDLE_MAX_BODY, recordStop, &lengths[k]);
+        if (result != CPU_LOOP) {
+            return result;
+        }
+    }
+    headA[3] = cpu->a;
+    headD[3] = cpu->d;
+
+    uint16_t deltaA = headA[3] - headA[2];
+    uint16_t deltaD = headD[3] - headD[2];
+    if (lengths[0] != lengths[1] || lengths[1] != lengths[2] ||
+        (uint16_t) (headA[2] - headA[1]) != deltaA || (uint16_t) (headA[1] - headA[0]) != deltaA ||
+        (uint16_t) (headD[2] - headD[1]) != deltaD || (uint16_t) (headD[1] - headD[0]) != deltaD) {
+        return IDLE_GIVE_UP;
+    }
+
+    size_t length = lengths[0];
+    const IdleStep * first = idle->trace;
+    const IdleStep * second = idle->trace + IDLE_MAX_BODY;
+    const IdleStep * third = idle->trace + 2 * IDLE_MAX_BODY;
+
+    uint16_t writeAddresses[IDLE_MAX_WRITES];
+    uint16_t writeDeltas[IDLE_MAX_WRITES];
+    size_t writeCount = 0;
+    bool readsInput = false;
+    bool changes = deltaA != 0 || deltaD != 0;
+    uint64_t iterations = UINT64_MAX;
+
+    for (size_t i = 0; i < length; i++) {
+        if (first[i].pc != second[i].pc || second[i].pc != third[i].pc) {
+            return IDLE_GIVE_UP;
+        }
+        uint16_t delta = third[i].out - second[i].out;
+        if ((uint16_t) (second[i].out - first[i].out) != delta) {
+            return IDLE_GIVE_UP;
+        }
+        changes |= delta != 0;
+
+        uint16_t instruction = cpu->rom[third[i].pc];
+        if (!(instruction & 0x8000)) {
+            continue;
+        }
+
+        bool readsM = instruction & 0x1000;
+        bool writesM = instruction & 0x0008;
+        uint16_t address = third[i].address & RAM_MASK;
+        if ((readsM || writesM) &&
+            (first[i].address != second[i].address || second[i].address != third[i].address)) {
+            return IDLE_GIVE_UP;
+        }
+        if ((readsM || writesM) && cpu->devices && address > RAM_KBD) {
+            return IDLE_GIVE_UP;
+        }
+        readsInput |= readsM && address == RAM_KBD;
+
+        if (!isAffine(instruction) &&
+            (first[i].x != second[i].x || second[i].x != third[i].x ||
+             first[i].y != second[i].y || second[i].y != third[i].y)) {
+            return IDLE_GIVE_UP;
+        }
+
+        if (writesM) {
+            size_t w = 0;
+            while (w < writeCount && writeAddresses[w] != address) {
+                w++;
+            }
+            if (w == IDLE_MAX_WRITES) {
+                return IDLE_GIVE_UP;
+            }
+            writeAddresses[w] = address;
+            writeDeltas[w] = delta;
+            writeCount += w == writeCount;
+        }
+
+        uint16_t jump = instruction & 0x7;
+        if (jump != 0 && jump != 0x7 && delta != 0) {
+            uint64_t n = firstChange(third[i].out, delta);
+            if (n < iterations) {
+                iterations = n;
+            }
+        }
+    }
+
+    // Iteration 3 + iterations is the first to behave differently; run it natively
+    uint64_t skip = iterations == UINT64_MAX ? UINT64_MAX : iterations - 1;
+    if (iterations == UINT64_MAX && (!readsInput || inputCycle == 0)) {
+        return changes ? IDLE_GIVE_UP : CPU_HALT;
+    }
+    if (readsInput && inputCycle) {
+        uint64_t untilInput = (inputCycle - cpu->cycles) / length;
+        skip = skip < untilInput ? skip : untilInput;
+    }
+    if (stopCycle) {
+        uint64_t untilStop = (stopCycle - cpu->cycles) / length;
+        skip = skip < untilStop ? skip : untilStop;
+    }
+    if (skip == 0) {
+        return CPU_LOOP;
+    }
+
+    uint16_t factor = (uint16_t) skip;
+    for (size_t w = 0; w < writeCount; w++) {
+        cpu->ram[writeAddresses[w]] += (uint16_t) (factor * writeDeltas[w]);
+    }
+    cpu->a += (uint16_t) (factor * deltaA);
+    cpu->d += (uint16_t) (factor * deltaD);
+    cpu->cycles += skip * length;
+
+    idle->skips++;
+    idle->skippedCycles += skip * length;
+    return CPU_LOOP;
+}
+
+/**
+ * @brief Allocates probe storage and enables back-edge counting on the CPU
+ * 
+ * @param idle Pointer to the state to initialize
+ * @param cpu Pointer to the CPU
+ * @return true on success, false if allocation failed
+ */
+bool initIdle(Idle * idle, CPU * cpu) {
+    memset(idle, 0, sizeof(Idle));
+    idle->trace = malloc(3 * IDLE_MAX_BODY * sizeof(IdleStep));
+    if (idle->trace == NULL || !enableLoopCounting(cpu)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(idle->trace);
+        idle->trace = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Probes the loop at the current PC and fast-forwards it if possible
+ * 
+ * Loops that cannot be skipped have their back-edge counter pushed far below
+ * the threshold so they are not probed again soon; loops that were skipped
+ * are probed again on their next back edge.
+ * 
+ * @param idle Pointer to the fast-forward state
+ * @param cpu Pointer to the CPU, stopped on a loop head
+ * @param stopCycle Cycle at which to stop (0 for no limit)
+ * @param inputCycle Cycle of the next KBD change (0 if none is pending)
+ * @return CPU_LOOP to continue running, or CPU_BREAK, CPU_HALT or CPU_LIMIT
+ */
+int idleProbe(Idle * idle, CPU * cpu, uint64_t stopCycle, uint64_t inputCycle) {
+    uint16_t head = cpu->pc;
+    if (cpu->breakpoints[head]) {
+        cpu->backEdges[head] = INT16_MIN;
+        return CPU_BREAK;
+    }
+
+    idle->probes++;
+    uint64_t skipped = idle->skippedCycles;
+    int result = fastForward(idle, cpu, stopCycle, inputCycle);
+
+    if (result == IDLE_GIVE_UP || result == CPU_BREAK) {
+        cpu->backEdges[head] = INT16_MIN;
+    } else if (idle->skippedCycles != skipped) {
+        cpu->backEdges[head] = LOOP_THRESHOLD - 1;
+    } else {
+        cpu->backEdges[head] = 0;
+    }
+    return result == IDLE_GIVE_UP ? CPU_LOOP : result;
+}
+
+/**
+ * @brief Frees all memory owned by the fast-forward state
+ * 
+ * @param idle Pointer to the state to clean up
+ */
+void cleanupIdle(Idle * idle) {
+    free(idle->trace);
+    idle->trace = NULL;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file Idle.h
+ * @brief Idle-loop detection and fast-forward for the native Hack Emulator
+ * 
+ * When cpuRun reports a hot loop head, the loop is probed by executing three
+ * iterations one instruction at a time. If every iteration follows the same
+ * path, touches the same RAM addresses and changes each computed value by a
+ * constant amount (the loop only counts), the number of iterations until any
+ * conditional jump changes its outcome is computed in closed form and all but
+ * the last of them are skipped by applying the per-iteration deltas directly.
+ * A loop whose values do not change at all only waits: it is skipped up to
+ * the next keyboard event if it reads KBD, and otherwise treated as a halt.
+ */
+
+#ifndef IDLE_H
+#define IDLE_H
+
+#include "Config.h"
+#include "CPU.h"
+
+// Probe Limits
+#define IDLE_MAX_BODY       1024    // Instructions per recorded iteration
+#define IDLE_MAX_WRITES     64      // Distinct RAM addresses written per iteration
+
+/**
+ * @brief One executed instruction of a recorded loop iteration
+ */
+typedef struct IdleStep {
+    uint16_t pc;
+    uint16_t address;           // A register before the instruction
+    uint16_t x;                 // D register before the instruction
+    uint16_t y;                 // A or M operand
+    uint16_t out;               // ALU output, or the loaded constant for A-instructions
+} IdleStep;
+
+/**
+ * @brief Fast-forward state and statistics
+ */
+typedef struct Idle {
+    IdleStep * trace;           // Three iterations of IDLE_MAX_BODY steps each
+    uint64_t probes;            // Loops examined
+    uint64_t skips;             // Loops fast-forwarded
+    uint64_t skippedCycles;     // Cycles accounted for without executing them
+} Idle;
+
+/**
+ * @brief Allocates probe storage and enables back-edge counting on the CPU
+ * 
+ * @param idle Pointer to the state to initialize
+ * @param cpu Pointer to the CPU
+ * @return true on success, false if allocation failed
+ */
+bool initIdle(Idle * idle, CPU * cpu);
+
+/**
+ * @brief Probes the loop at the current PC and fast-forwards it if possible
+ * 
+ * The probe executes real instructions, so it stops like cpuRun does: at
+ * breakpoints, at halt loops and at the stop cycle.
+ * 
+ * @param idle Pointer to the fast-forward state
+ * @param cpu Pointer to the CPU, stopped on a loop head
+ * @param stopCycle Cycle at which to stop (0 for no limit)
+ * @param inputCycle Cycle of the next KBD change (0 if none is pending)
+ * @return CPU_LOOP to continue running, or CPU_BREAK, CPU_HALT or CPU_LIMIT
+ */
+int idleProbe(Idle * idle, CPU * cpu, uint64_t stopCycle, uint64_t inputCycle);
+
+/**
+ * @brief Frees all memory owned by the fast-forward state
+ * 
+ * @param idle Pointer to the state to clean up
+ */
+void cleanupIdle(Idle * idle);
+
+#endif
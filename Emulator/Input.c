@@ -0,0 +1,124 @@
+/**
+ * @file Input.c
+ * @brief Scripted keyboard input module for the native Hack Emulator
+ * 
+ * This file contains functions for loading keyboard scripts and applying
+ * their events to the KBD register as emulation reaches each event's cycle
+ * or call count.
+ */
+
+#include "Input.h"
+
+/**
+ * @brief Loads a keyboard script
+ * 
+ * Events must be listed in non-decreasing time order. The script counts
+ * cycles until the caller sets countsCalls.
+ * 
+ * @param script Pointer to the script to fill
+ * @param path Path of the script file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadInput(InputScript * script, const char * path) {
+    script->events = NULL;
+    script->count = 0;
+    script->next = 0;
+    script->countsCalls = false;
+    script->calls = 0;
+
+    FILE * inputFile = fopen(path, "r");
+    if (inputFile == NULL) {
+        perror("fopen keys failed");
+        return false;
+    }
+
+    size_t capacity = 0;
+    char currLine[MAX_LINE_LENGTH];
+    while (fgets(currLine, sizeof(currLine), inputFile)) {
+        unsigned long long time;
+        unsigned int key;
+        char first;
+        if (sscanf(currLine, " %c", &first) != 1 || first == '#') {
+            continue;
+        }
+        if (sscanf(currLine, "%llu %u", &time, &key) != 2 || key > 0xFFFF ||
+            (script->count > 0 && time < script->events[script->count - 1].time)) {
+            fprintf(stderr, "Error: Invalid key event in %s: %s", path, currLine);
+            fclose(inputFile);
+            cleanupInput(script);
+            return false;
+        }
+
+        if (script->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            KeyEvent * events = realloc(script->events, capacity * sizeof(KeyEvent));
+            if (events == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                fclose(inputFile);
+                cleanupInput(script);
+                return false;
+            }
+            script->events = events;
+        }
+        script->events[script->count].time = time;
+        script->events[script->count].key = (uint16_t) key;
+        script->count++;
+    }
+
+    fclose(inputFile);
+    return true;
+}
+
+/**
+ * @brief Returns the cycle of the next pending event
+ * 
+ * @param script Pointer to the script
+ * @return The cycle of the next event, or 0 if none is pending or the script counts calls
+ */
+uint64_t nextInputCycle(const InputScript * script) {
+    if (script->countsCalls || script->next >= script->count) {
+        return 0;
+    }
+    return script->events[script->next].time;
+}
+
+/**
+ * @brief Applies every event scheduled at or before the current cycle or call count
+ * 
+ * @param script Pointer to the script
+ * @param cpu Pointer to the CPU whose KBD register is updated
+ */
+void applyInput(InputScript * script, CPU * cpu) {
+    uint64_t now = script->countsCalls ? script->calls : cpu->cycles;
+    while (script->next < script->count && script->events[script->next].time <= now) {
+        cpu->ram[RAM_KBD] = script->events[script->next].key;
+        script->next++;
+    }
+}
+
+/**
+ * @brief Counts a call to the script's function and applies the events it reaches
+ * 
+ * The event for call N is applied on entry to the Nth call, before the
+ * function runs, so a function that reads the keyboard sees it.
+ * 
+ * @param script Pointer to a script that counts calls
+ * @param cpu Pointer to the CPU whose KBD register is updated
+ */
+void countInputCall(InputScript * script, CPU * cpu) {
+    script->calls++;
+    applyInput(script, cpu);
+}
+
+/**
+ * @brief Frees all memory owned by the script
+ * 
+ * @param script Pointer to the script to clean up
+ */
+void cleanupInput(InputScript * script) {
+    free(script->events);
+    script->events = NULL;
+    script->count = 0;
+    script->next = 0;
+    script->calls = 0;
+}
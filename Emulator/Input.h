@@ -0,0 +1,79 @@
+/**
+ * @file Input.h
+ * @brief Scripted keyboard input for the native Hack Emulator
+ * 
+ * This header declares a list of keyboard events, each setting the KBD
+ * register to a key code at a given cycle. Events are read from a text file
+ * with one "CYCLE KEY" pair per line (KEY 0 releases the key); lines
+ * starting with '#' are comments. A script can instead count calls to one
+ * function, such as the routine a game calls once per frame: an event then
+ * fires on entry to that call, so the input no longer depends on how many
+ * cycles the program spends between its frames.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "Config.h"
+#include "CPU.h"
+
+/**
+ * @brief One scheduled change of the KBD register
+ */
+typedef struct KeyEvent {
+    uint64_t time;              // Cycle, or call count when the script counts calls
+    uint16_t key;
+} KeyEvent;
+
+/**
+ * @brief Scheduled keyboard events in time order
+ */
+typedef struct InputScript {
+    KeyEvent * events;
+    size_t count;
+    size_t next;                // Index of the first event not yet applied
+    bool countsCalls;           // Event times are call counts rather than cycles
+    uint64_t calls;             // Calls counted so far
+} InputScript;
+
+/**
+ * @brief Loads a keyboard script
+ * 
+ * @param script Pointer to the script to fill
+ * @param path Path of the script file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadInput(InputScript * script, const char * path);
+
+/**
+ * @brief Returns the cycle of the next pending event
+ * 
+ * @param script Pointer to the script
+ * @return The cycle of the next event, or 0 if none is pending or the script counts calls
+ */
+uint64_t nextInputCycle(const InputScript * script);
+
+/**
+ * @brief Applies every event scheduled at or before the current cycle or call count
+ * 
+ * @param script Pointer to the script
+ * @param cpu Pointer to the CPU whose KBD register is updated
+ */
+void applyInput(InputScript * script, CPU * cpu);
+
+/**
+ * @brief Counts a call to the script's function and applies the events it reaches
+ * 
+ * @param script Pointer to a script that counts calls
+ * @param cpu Pointer to the CPU whose KBD register is updated
+ */
+void countInputCall(InputScript * script, CPU * cpu);
+
+/**
+ * @brief Frees all memory owned by the script
+ * 
+ * @param script Pointer to the script to clean up
+ */
+void cleanupInput(InputScript * script);
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * @file Loader.c
+ * @brief Program and symbol file loading module for the native Hack Emulator
+ * 
+ * This file contains functions for reading assembled .hack programs into ROM
+ * and for reading the .sym files written by the assembler's -s option,
+ * together with the .map file of VMTranslator --short-labels.
+ */
+
+#include "Config.h"
+#include "Loader.h"
+
+#include <limits.h>
+
+/**
+ * @brief Loads a .hack file into ROM
+ * 
+ * Each non-empty line must contain exactly INSTRUCTION_WIDTH binary digits.
+ * Trailing whitespace and carriage returns are ignored.
+ * 
+ * @param cpu Pointer to the CPU whose ROM is filled
+ * @param path Path of the .hack file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadProgram(CPU * cpu, const char * path) {
+    FILE * inputFile = fopen(path, "r");
+    if (inputFile == NULL) {
+        perror("fopen program failed");
+        return false;
+    }
+
+    char currLine[MAX_LINE_LENGTH];
+    uint32_t address = 0;
+    unsigned long lineNumber = 0;
+    while (fgets(currLine, sizeof(currLine), inputFile)) {
+        lineNumber++;
+        size_t length = strlen(currLine);
+        while (length > 0 && isspace((unsigned char) currLine[length - 1])) {
+            currLine[--length] = '\0';
+        }
+        if (length == 0) {
+            continue;
+        }
+
+        if (length != INSTRUCTION_WIDTH || address >= ROM_SIZE) {
+            fprintf(stderr, "Error: Invalid instruction at %s:%lu\n", path, lineNumber);
+            fclose(inputFile);
+            return false;
+        }
+
+        uint16_t instruction = 0;
+        for (int i = 0; i < INSTRUCTION_WIDTH; i++) {
+            if (currLine[i] != '0' && currLine[i] != '1') {
+                fprintf(stderr, "Error: Invalid instruction at %s:%lu\n", path, lineNumber);
+                fclose(inputFile);
+                return false;
+            }
+            instruction = (uint16_t) ((instruction << 1) | (currLine[i] - '0'));
+        }
+        cpu->rom[address++] = instruction;
+    }
+
+    cpu->romLength = address;
+    fclose(inputFile);
+    return true;
+}
+
+/**
+ * @brief Decodes a short label name ("$" and lowercase base-36 digits)
+ * 
+ * @param name The symbol name
+ * @return The label id, or -1 if the name is not a short label
+ */
+static long parseShortLabel(const char * name) {
+    if (name[0] != '$' || name[1] == '\0') {
+        return -1;
+    }
+    long id = 0;
+    for (const char * c = name + 1; *c != '\0'; c++) {
+        int digit;
+        if (*c >= '0' && *c <= '9') {
+            digit = *c - '0';
+        } else if (*c >= 'a' && *c <= 'z') {
+            digit = *c - 'a' + 10;
+        } else {
+            return -1;
+        }
+        if (id > (LONG_MAX - digit) / 36) {
+            return -1;
+        }
+        id = id * 36 + digit;
+    }
+    return id;
+}
+
+/**
+ * @brief Restores the original names of short labels from a .map file
+ * 
+ * The translator gives out short label ids densely, so the map is read
+ * into an array indexed by id. Symbols without a map entry keep their
+ * names, and a missing map file leaves the list unchanged.
+ * 
+ * @param symbols Pointer to the symbol list to rename
+ * @param path Path of the .map file
+ * @return true on success or when there is no map, false on format or allocation errors
+ */
+static bool applyLabelMap(Symbols * symbols, const char * path) {
+    FILE * inputFile = fopen(path, "r");
+    if (inputFile == NULL) {
+        return true;
+    }
+
+    char ** names = NULL;
+    size_t count = 0;
+    char currLine[MAX_LINE_LENGTH + MAX_NAME_LENGTH];
+    char shortName[MAX_NAME_LENGTH];
+    char name[MAX_NAME_LENGTH];
+    bool valid = true;
+    while (valid && fgets(currLine, sizeof(currLine), inputFile)) {
+        valid = sscanf(currLine, "%255s %255s", shortName, name) == 2 && parseShortLabel(shortName) == (long) count;
+        if (valid && (count & (count - 1)) == 0) {
+            char ** grown = realloc(names, (count ? count * 2 : 1) * sizeof(char *));
+            valid = grown != NULL;
+            names = valid ? grown : names;
+        }
+        if (valid) {
+            names[count] = malloc(strlen(name) + 1);
+            valid = names[count] != NULL;
+        }
+        if (valid) {
+            strcpy(names[count++], name);
+        }
+    }
+    fclose(inputFile);
+    if (!valid) {
+        fprintf(stderr, "Error: Invalid label map %s\n", path);
+    }
+
+    for (size_t i = 0; valid && i < symbols->count; i++) {
+        long id = parseShortLabel(symbols->entries[i].name);
+        if (id >= 0 && (size_t) id < count) {
+            free(symbols->entries[i].name);
+            symbols->entries[i].name = names[id];
+            names[id] = NULL;
+        }
+    }
+    for (size_t id = 0; id < count; id++) {
+        free(names[id]);
+    }
+    free(names);
+    return valid;
+}
+
+/**
+ * @brief Sets a symbol list to empty with the default memory map
+ * 
+ * @param symbols Pointer to the symbol list to initialize
+ */
+void initSymbols(Symbols * symbols) {
+    symbols->entries = NULL;
+    symbols->count = 0;
+    symbols->capacity = 0;
+    initMemoryMap(&symbols->layout);
+}
+
+/**
+ * @brief Stores one "M <address> <bound>" line of a .sym file in the layout
+ * 
+ * @param layout Pointer to the memory map receiving the bound
+ * @param bound Name of the bound, such as "heap.base"
+ * @param address The bound's address
+ * @return true on success, false if the bound is unknown
+ */
+static bool setLayoutBound(MemoryMap * layout, const char * bound, uint16_t address) {
+    if (strcmp(bound, "statics.base") == 0) {
+        layout->staticBase = address;
+    } else if (strcmp(bound, "statics.limit") == 0) {
+        layout->staticLimit = address;
+    } else if (strcmp(bound, "stack.base") == 0) {
+        layout->stackBase = address;
+    } else if (strcmp(bound, "stack.limit") == 0) {
+        layout->stackLimit = address;
+    } else if (strcmp(bound, "heap.base") == 0) {
+        layout->heapBase = address;
+    } else if (strcmp(bound, "heap.limit") == 0) {
+        layout->heapLimit = address;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads a .sym file written by the assembler
+ * 
+ * The memory map lines at the start of the file set the layout; files
+ * without them keep the default one. If a .map file written by VMTranslator --short-labels lies next to the
+ * .sym file, short label names are replaced by the original ones, so
+ * lookups by name work the same for both kinds of build.
+ * 
+ * @param symbols Pointer to the symbol list to fill
+ * @param path Path of the .sym file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadSymbols(Symbols * symbols, const char * path) {
+    initSymbols(symbols);
+
+    FILE * inputFile = fopen(path, "r");
+    if (inputFile == NULL) {
+        perror("fopen symbols failed");
+        return false;
+    }
+
+    char currLine[MAX_LINE_LENGTH];
+    char name[MAX_NAME_LENGTH];
+    char kind;
+    unsigned int address;
+    while (fgets(currLine, sizeof(currLine), inputFile)) {
+        if (sscanf(currLine, " %c %u %255s", &kind, &address, name) != 3 ||
+            (kind != 'L' && kind != 'V' && kind != 'M') || address >= ROM_SIZE ||
+            (kind == 'M' && !setLayoutBound(&symbols->layout, name, (uint16_t) address))) {
+            fprintf(stderr, "Error: Invalid symbol line in %s: %s", path, currLine);
+            fclose(inputFile);
+            cleanupSymbols(symbols);
+            return false;
+        }
+        if (kind == 'M') {
+            continue;
+        }
+
+        if (symbols->count == symbols->capacity) {
+            size_t capacity = symbols->capacity ? symbols->capacity * 2 : 256;
+            SymbolEntry * entries = realloc(symbols->entries, capacity * sizeof(SymbolEntry));
+            if (entries == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                fclose(inputFile);
+                cleanupSymbols(symbols);
+                return false;
+            }
+            symbols->entries = entries;
+            symbols->capacity = capacity;
+        }
+
+        SymbolEntry * entry = &symbols->entries[symbols->count];
+        entry->name = malloc(strlen(name) + 1);
+        if (entry->name == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            fclose(inputFile);
+            cleanupSymbols(symbols);
+            return false;
+        }
+        strcpy(entry->name, name);
+        entry->address = (uint16_t) address;
+        entry->kind = kind;
+        symbols->count++;
+    }
+    fclose(inputFile);
+    if (!validateMemoryMap(&symbols->layout)) {
+        fprintf(stderr, "Error: Invalid memory map in %s\n", path);
+        cleanupSymbols(symbols);
+        return false;
+    }
+
+    char mapPath[MAX_LINE_LENGTH];
+    size_t pathLength = strlen(path);
+    if (pathLength > 4 && strcmp(path + pathLength - 4, ".sym") == 0 && pathLength < sizeof(mapPath)) {
+        snprintf(mapPath, sizeof(mapPath), "%.*s.map", (int) (pathLength - 4), path);
+        if (!applyLabelMap(symbols, mapPath)) {
+            cleanupSymbols(symbols);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Looks up the address of a symbol by exact name
+ * 
+ * @param symbols Pointer to the symbol list
+ * @param name The symbol name to look up
+ * @return The address, or -1 if the symbol is not present
+ */
+int findSymbol(const Symbols * symbols, const char * name) {
+    for (size_t i = 0; i < symbols->count; i++) {
+        if (strcmp(symbols->entries[i].name, name) == 0) {
+            return symbols->entries[i].address;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Looks up the RAM address of a VM static variable
+ * 
+ * Static names depend on how the translator was invoked: "Class.vm.i" in
+ * directory mode, "Class.i" or "path/Class.i" in single-file mode.
+ * 
+ * @param symbols Pointer to the symbol list
+ * @param className The Jack class owning the static
+ * @param index The static segment index
+ * @return The RAM address, or -1 if the static is not present
+ */
+int findStatic(const Symbols * symbols, const char * className, int index) {
+    char directName[MAX_NAME_LENGTH];
+    char fileName[MAX_NAME_LENGTH];
+    snprintf(directName, sizeof(directName), "%s.vm.%d", className, index);
+    snprintf(fileName, sizeof(fileName), "%s.%d", className, index);
+    size_t fileLength = strlen(fileName);
+
+    for (size_t i = 0; i < symbols->count; i++) {
+        const SymbolEntry * entry = &symbols->entries[i];
+        if (entry->kind != 'V') {
+            continue;
+        }
+        if (strcmp(entry->name, directName) == 0 || strcmp(entry->name, fileName) == 0) {
+            return entry->address;
+        }
+        size_t length = strlen(entry->name);
+        if (length > fileLength && entry->name[length - fileLength - 1] == '/' &&
+            strcmp(entry->name + length - fileLength, fileName) == 0) {
+            return entry->address;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Frees all memory owned by a symbol list
+ * 
+ * @param symbols Pointer to the symbol list to clean up
+ */
+void cleanupSymbols(Symbols * symbols) {
+    for (size_t i = 0; i < symbols->count; i++) {
+        free(symbols->entries[i].name);
+    }
+    free(symbols->entries);
+    symbols->entries = NULL;
+    symbols->count = 0;
+    symbols->capacity = 0;
+}
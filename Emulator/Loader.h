@@ -0,0 +1,92 @@
+/**
+ * @file Loader.h
+ * @brief Program and symbol file loading for the native Hack Emulator
+ * 
+ * This header declares functions for loading assembled .hack programs into
+ * ROM and for reading the .sym files written by the assembler's -s option.
+ * Apart from the assembler's MemoryMap.h, which describes the layout a
+ * program was built for, it only depends on system headers like CPU.h.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stddef.h>
+
+#include "CPU.h"
+#include "../Assembler/MemoryMap.h"
+
+/**
+ * @brief One label or variable from a .sym file
+ */
+typedef struct SymbolEntry {
+    char * name;
+    uint16_t address;
+    char kind;                  // 'L' for labels, 'V' for variables
+} SymbolEntry;
+
+/**
+ * @brief Dynamic array of symbols in file order and the program's memory map
+ */
+typedef struct Symbols {
+    SymbolEntry * entries;
+    size_t count;
+    size_t capacity;
+    MemoryMap layout;           // Layout recorded by the assembler, or the default one
+} Symbols;
+
+/**
+ * @brief Loads a .hack file into ROM
+ * 
+ * @param cpu Pointer to the CPU whose ROM is filled
+ * @param path Path of the .hack file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadProgram(CPU * cpu, const char * path);
+
+/**
+ * @brief Sets a symbol list to empty with the default memory map
+ * 
+ * @param symbols Pointer to the symbol list to initialize
+ */
+void initSymbols(Symbols * symbols);
+
+/**
+ * @brief Loads a .sym file written by the assembler
+ * 
+ * @param symbols Pointer to the symbol list to fill
+ * @param path Path of the .sym file
+ * @return true on success, false on I/O or format errors
+ */
+bool loadSymbols(Symbols * symbols, const char * path);
+
+/**
+ * @brief Looks up the address of a symbol by exact name
+ * 
+ * @param symbols Pointer to the symbol list
+ * @param name The symbol name to look up
+ * @return The address, or -1 if the symbol is not present
+ */
+int findSymbol(const Symbols * symbols, const char * name);
+
+/**
+ * @brief Looks up the RAM address of a VM static variable
+ * 
+ * Static names depend on how the translator was invoked: "Class.vm.i" in
+ * directory mode, "Class.i" or "path/Class.i" in single-file mode.
+ * 
+ * @param symbols Pointer to the symbol list
+ * @param className The Jack class owning the static
+ * @param index The static segment index
+ * @return The RAM address, or -1 if the static is not present
+ */
+int findStatic(const Symbols * symbols, const char * className, int index);
+
+/**
+ * @brief Frees all memory owned by a symbol list
+ * 
+ * @param symbols Pointer to the symbol list to clean up
+ */
+void cleanupSymbols(Symbols * symbols);
+
+#endif
@@ -0,0 +1,280 @@
+/**
+ * @file Profiler.c
+ * @brief Sampling profiler module for the native Hack Emulator
+ * 
+ * This file implements the lock-free sample ring and its drainer thread.
+ * The emulator thread is the only writer of head and the drainer the only
+ * writer of tail; release/acquire ordering on these indices publishes each
+ * sample slot between the two threads without locks.
+ */
+
+#include "Profiler.h"
+
+#include <time.h>
+
+// Drainer back-off when the ring is empty
+#define DRAIN_SLEEP_NS  1000000L
+
+// Symbol list consulted by compareFunctions during qsort
+static const Symbols * sortSymbols;
+
+/**
+ * @brief Orders function table indices by entry address
+ */
+static int compareFunctions(const void * left, const void * right) {
+    uint16_t a = sortSymbols->entries[*(const size_t *) left].address;
+    uint16_t b = sortSymbols->entries[*(const size_t *) right].address;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Tells whether a label names a VM function ("Class.name" without '$')
+ */
+static bool isFunctionLabel(const SymbolEntry * entry) {
+    return entry->kind == 'L' && strchr(entry->name, '.') != NULL && strchr(entry->name, '$') == NULL;
+}
+
+/**
+ * @brief Builds the sorted table of function entry addresses
+ * 
+ * @return true on success, false if allocation failed
+ */
+static bool buildFunctionTable(Profiler * profiler, const Symbols * symbols) {
+    size_t * order = malloc((symbols->count + 1) * sizeof(size_t));
+    profiler->functionStarts = malloc((symbols->count + 1) * sizeof(uint16_t));
+    profiler->functionNames = malloc((symbols->count + 1) * sizeof(char *));
+    profiler->selfSamples = calloc(symbols->count + 1, sizeof(uint64_t));
+    if (order == NULL || profiler->functionStarts == NULL || profiler->functionNames == NULL ||
+        profiler->selfSamples == NULL) {
+        free(order);
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < symbols->count; i++) {
+        if (isFunctionLabel(&symbols->entries[i])) {
+            order[count++] = i;
+        }
+    }
+    sortSymbols = symbols;
+    qsort(order, count, sizeof(size_t), compareFunctions);
+
+    for (size_t i = 0; i < count; i++) {
+        profiler->functionStarts[i] = symbols->entries[order[i]].address;
+        profiler->functionNames[i] = symbols->entries[order[i]].name;
+    }
+    profiler->functionCount = count;
+    free(order);
+    return true;
+}
+
+/**
+ * @brief Finds the function containing a ROM address
+ * 
+ * @return Index into the function table, or functionCount if the address
+ *         precedes every function (the bootstrap code)
+ */
+static size_t findFunction(const Profiler * profiler, uint16_t address) {
+    size_t low = 0;
+    size_t high = profiler->functionCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (profiler->functionStarts[middle] <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low == 0 ? profiler->functionCount : low - 1;
+}
+
+/**
+ * @brief Writes the name of the function containing an address
+ */
+static void writeFunction(const Profiler * profiler, uint16_t address) {
+    size_t index = findFunction(profiler, address);
+    if (index < profiler->functionCount) {
+        fputs(profiler->functionNames[index], profiler->outputFile);
+    } else if (profiler->functionCount > 0) {
+        fputs("(bootstrap)", profiler->outputFile);
+    } else {
+        fprintf(profiler->outputFile, "0x%04X", address);
+    }
+}
+
+/**
+ * @brief Writes one sample as a folded stack line, outermost frame first
+ * 
+ * Return addresses are resolved through the preceding instruction (the
+ * caller's jump), since a return label may coincide with the entry of the
+ * function placed right after the call.
+ */
+static void writeSample(Profiler * profiler, const ProfileSample * sample) {
+    for (int i = sample->depth - 1; i >= 0; i--) {
+        writeFunction(profiler, i > 0 ? (uint16_t) (sample->frames[i] - 1) : sample->frames[i]);
+        fputc(i > 0 ? ';' : ' ', profiler->outputFile);
+    }
+    fprintf(profiler->outputFile, "%u\n", sample->weight);
+
+    profiler->selfSamples[findFunction(profiler, sample->frames[0])] += sample->weight;
+    profiler->totalSamples += sample->weight;
+}
+
+/**
+ * @brief Drainer thread: consumes samples until the profiler is stopped
+ */
+static void * drain(void * argument) {
+    Profiler * profiler = argument;
+    const struct timespec pause = { 0, DRAIN_SLEEP_NS };
+
+    for (;;) {
+        size_t tail = atomic_load_explicit(&profiler->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&profiler->head, memory_order_acquire);
+        if (tail == head) {
+            if (atomic_load_explicit(&profiler->done, memory_order_acquire) &&
+                tail == atomic_load_explicit(&profiler->head, memory_order_acquire)) {
+                break;
+            }
+            nanosleep(&pause, NULL);
+            continue;
+        }
+
+        while (tail != head) {
+            writeSample(profiler, &profiler->ring[tail & (PROFILE_RING_SIZE - 1)]);
+            tail++;
+        }
+        atomic_store_explicit(&profiler->tail, tail, memory_order_release);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Opens the output file and starts the drainer thread
+ * 
+ * @param profiler Pointer to the profiler to initialize
+ * @param symbols Symbols used to name functions (may be empty)
+ * @param path Path of the folded-stack output file
+ * @param interval Cycles between samples
+ * @return true on success, false on error
+ */
+bool startProfiler(Profiler * profiler, const Symbols * symbols, const char * path, uint64_t interval) {
+    memset(profiler, 0, sizeof(Profiler));
+    atomic_init(&profiler->head, 0);
+    atomic_init(&profiler->tail, 0);
+    atomic_init(&profiler->done, false);
+    profiler->interval = interval ? interval : 1;
+    profiler->nextCycle = profiler->interval;
+    profiler->stackBase = symbols->layout.stackBase;
+    profiler->stackLimit = symbols->layout.stackLimit;
+
+    profiler->ring = malloc(PROFILE_RING_SIZE * sizeof(ProfileSample));
+    if (profiler->ring == NULL || !buildFunctionTable(profiler, symbols)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        stopProfiler(profiler, NULL);
+        return false;
+    }
+
+    profiler->outputFile = fopen(path, "w");
+    if (profiler->outputFile == NULL) {
+        perror("fopen profile failed");
+        stopProfiler(profiler, NULL);
+        return false;
+    }
+
+    if (pthread_create(&profiler->drainer, NULL, drain, profiler) != 0) {
+        fprintf(stderr, "Error: Could not start profiler thread\n");
+        fclose(profiler->outputFile);
+        profiler->outputFile = NULL;
+        stopProfiler(profiler, NULL);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Records a sample of the current PC and call stack
+ * 
+ * A sample taken after a fast-forward stands for every sampling period the
+ * skipped cycles covered. The stack walk stops at the bootstrap frame, at
+ * PROFILE_MAX_DEPTH, or on a frame pointer that cannot belong to the stack
+ * (the machine may be in the middle of a call or return sequence).
+ * 
+ * @param profiler Pointer to the profiler
+ * @param cpu Pointer to the CPU
+ */
+void profilerSample(Profiler * profiler, const CPU * cpu) {
+    uint64_t periods = (cpu->cycles - profiler->nextCycle) / profiler->interval + 1;
+    profiler->nextCycle += periods * profiler->interval;
+
+    size_t head = atomic_load_explicit(&profiler->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&profiler->tail, memory_order_acquire);
+    if (head - tail == PROFILE_RING_SIZE) {
+        profiler->dropped += periods;
+        return;
+    }
+
+    ProfileSample * sample = &profiler->ring[head & (PROFILE_RING_SIZE - 1)];
+    sample->cycle = cpu->cycles;
+    sample->weight = periods > UINT32_MAX ? UINT32_MAX : (uint32_t) periods;
+    sample->frames[0] = cpu->pc;
+    sample->depth = 1;
+
+    const uint16_t * ram = cpu->ram;
+    uint16_t frame = ram[RAM_LCL];
+    while (sample->depth < PROFILE_MAX_DEPTH && frame >= profiler->stackBase + 5 && frame <= profiler->stackLimit) {
+        sample->frames[sample->depth++] = ram[frame - 5];
+        uint16_t caller = ram[frame - 4];
+        if (caller >= frame) {
+            break;
+        }
+        frame = caller;
+    }
+
+    atomic_store_explicit(&profiler->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Stops the drainer, flushes the output and prints the hottest functions
+ * 
+ * @param profiler Pointer to the profiler
+ * @param outputFile Stream for the summary (NULL for none)
+ */
+void stopProfiler(Profiler * profiler, FILE * outputFile) {
+    if (profiler->outputFile != NULL) {
+        atomic_store_explicit(&profiler->done, true, memory_order_release);
+        pthread_join(profiler->drainer, NULL);
+        fclose(profiler->outputFile);
+        profiler->outputFile = NULL;
+    }
+
+    if (outputFile != NULL && profiler->totalSamples > 0) {
+        fprintf(outputFile, "Profile: %llu samples every %llu cycles (%llu dropped)\n",
+                (unsigned long long) profiler->totalSamples, (unsigned long long) profiler->interval,
+                (unsigned long long) profiler->dropped);
+        for (int rank = 0; rank < 10; rank++) {
+            size_t best = profiler->functionCount + 1;
+            for (size_t i = 0; i <= profiler->functionCount; i++) {
+                if (profiler->selfSamples[i] > 0 &&
+                    (best > profiler->functionCount || profiler->selfSamples[i] > profiler->selfSamples[best])) {
+                    best = i;
+                }
+            }
+            if (best > profiler->functionCount) {
+                break;
+            }
+            const char * name = best < profiler->functionCount ? profiler->functionNames[best] : "(other)";
+            fprintf(outputFile, "  %6.2f%%  %s\n",
+                    100.0 * profiler->selfSamples[best] / profiler->totalSamples, name);
+            profiler->selfSamples[best] = 0;
+        }
+    }
+
+    free(profiler->ring);
+    free(profiler->functionStarts);
+    free(profiler->functionNames);
+    free(profiler->selfSamples);
+    profiler->ring = NULL;
+    profiler->functionStarts = NULL;
+    profiler->functionNames = NULL;
+    profiler->selfSamples = NULL;
+}
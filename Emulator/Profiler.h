@@ -0,0 +1,88 @@
+/**
+ * @file Profiler.h
+ * @brief Sampling profiler for the native Hack Emulator
+ * 
+ * Every N cycles the emulator records the PC and a shallow call stack,
+ * walking the frames laid out by the VM translator's call sequence
+ * (return address at LCL-5, caller's LCL at LCL-4). Samples go into a
+ * single-producer/single-consumer lock-free ring buffer; a separate thread
+ * drains it, resolves addresses to function names and writes one folded
+ * stack per sample ("Sys.init;Main.main;Math.multiply 1"), the input format
+ * of flame graph tools. Sampling happens between cpuRun calls, so the
+ * instruction loop is unchanged and costs nothing extra when profiling is off.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Config.h"
+#include "CPU.h"
+#include "Loader.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Profiler Limits
+#define PROFILE_MAX_DEPTH       16      // Frames recorded per sample, including the PC
+#define PROFILE_RING_SIZE       4096    // Samples buffered between producer and drainer (power of two)
+
+/**
+ * @brief One stack sample
+ */
+typedef struct ProfileSample {
+    uint64_t cycle;
+    uint32_t weight;                    // Sampling periods covered (more than 1 after a fast-forward)
+    uint16_t depth;
+    uint16_t frames[PROFILE_MAX_DEPTH]; // PC first, then return addresses outwards
+} ProfileSample;
+
+/**
+ * @brief Sampling profiler state shared by the emulator and the drainer thread
+ */
+typedef struct Profiler {
+    ProfileSample * ring;
+    atomic_size_t head;                 // Next slot written by the emulator
+    atomic_size_t tail;                 // Next slot read by the drainer
+    atomic_bool done;
+    uint64_t interval;
+    uint64_t nextCycle;                 // Cycle of the next sample
+    uint64_t dropped;                   // Samples lost because the ring was full
+    uint16_t stackBase;                 // First word of the program's stack
+    uint16_t stackLimit;                // Last word of the stack; frames outside it end the walk
+    pthread_t drainer;
+    FILE * outputFile;
+    size_t functionCount;
+    uint16_t * functionStarts;          // Function entry addresses, ascending
+    const char ** functionNames;
+    uint64_t * selfSamples;             // Weighted samples per function (drainer only)
+    uint64_t totalSamples;
+} Profiler;
+
+/**
+ * @brief Opens the output file and starts the drainer thread
+ * 
+ * @param profiler Pointer to the profiler to initialize
+ * @param symbols Symbols used to name functions (may be empty)
+ * @param path Path of the folded-stack output file
+ * @param interval Cycles between samples
+ * @return true on success, false on error
+ */
+bool startProfiler(Profiler * profiler, const Symbols * symbols, const char * path, uint64_t interval);
+
+/**
+ * @brief Records a sample of the current PC and call stack
+ * 
+ * @param profiler Pointer to the profiler
+ * @param cpu Pointer to the CPU
+ */
+void profilerSample(Profiler * profiler, const CPU * cpu);
+
+/**
+ * @brief Stops the drainer, flushes the output and prints the hottest functions
+ * 
+ * @param profiler Pointer to the profiler
+ * @param outputFile Stream for the summary
+ */
+void stopProfiler(Profiler * profiler, FILE * outputFile);
+
+#endif
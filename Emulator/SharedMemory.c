@@ -0,0 +1,146 @@
+/**
+ * @file SharedMemory.c
+ * @brief Shared-memory export of the Hack RAM for external viewers
+ *
+ * The CPU's RAM pointer is redirected into the mapped object, so the
+ * instruction loop reads and writes shared memory directly and exporting
+ * costs nothing per instruction. Frames are published between cpuRun calls
+ * by the main loop, in the same way profiler samples are taken.
+ */
+
+#include "Config.h"
+#include "SharedMemory.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/**
+ * @brief Creates the shared-memory object and moves the CPU's RAM into it
+ *
+ * @param shared Pointer to the export state to initialize
+ * @param cpu Pointer to the CPU whose RAM is shared
+ * @param name Name of the POSIX shared-memory object (for example "/hack")
+ * @param frameCycles Instructions per frame
+ * @param framesPerSecond Frames per wall-clock second, or 0 for no pacing
+ * @return true on success, false on errors
+ */
+bool openSharedMemory(SharedMemory * shared, CPU * cpu, const char * name, uint64_t frameCycles, uint64_t framesPerSecond) {
+    memset(shared, 0, sizeof(SharedMemory));
+    if (frameCycles == 0) {
+        fprintf(stderr, "Error: Frame length must be positive\n");
+        return false;
+    }
+
+    int descriptor = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (descriptor < 0) {
+        perror("Error: shm_open");
+        return false;
+    }
+    if (ftruncate(descriptor, (off_t) SHARED_MEMORY_SIZE) != 0) {
+        perror("Error: ftruncate");
+        close(descriptor);
+        shm_unlink(name);
+        return false;
+    }
+
+    void * mapping = mmap(NULL, SHARED_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        perror("Error: mmap");
+        shm_unlink(name);
+        return false;
+    }
+
+    shared->name = strdup(name);
+    if (shared->name == NULL) {
+        munmap(mapping, SHARED_MEMORY_SIZE);
+        shm_unlink(name);
+        return false;
+    }
+
+    SharedHeader * header = mapping;
+    memset(header, 0, sizeof(SharedHeader));
+    header->magic = SHARED_MAGIC;
+    header->version = SHARED_VERSION;
+    header->ramOffset = sizeof(SharedHeader);
+    header->ramWords = RAM_SIZE;
+    header->screenAddress = RAM_SCREEN;
+    header->keyboardAddress = RAM_KBD;
+    header->state = SHARED_RUNNING;
+    header->frameCycles = (uint32_t) frameCycles;
+
+    uint16_t * ram = (uint16_t *) ((uint8_t *) mapping + sizeof(SharedHeader));
+    memcpy(ram, cpu->ram, RAM_SIZE * sizeof(uint16_t));
+    shared->privateRam = cpu->ram;
+    cpu->ram = ram;
+
+    shared->header = header;
+    shared->frameCycles = frameCycles;
+    shared->nextFrame = cpu->cycles + frameCycles;
+    shared->framesPerSecond = framesPerSecond;
+    shared->startTime = now();
+    return true;
+}
+
+/**
+ * @brief Publishes every frame completed by the current cycle count
+ *
+ * @param shared Pointer to the export state
+ * @param cpu Pointer to the CPU
+ */
+void publishFrame(SharedMemory * shared, const CPU * cpu) {
+    SharedHeader * header = shared->header;
+    uint64_t frames = header->frameSequence;
+    while (cpu->cycles >= shared->nextFrame) {
+        shared->nextFrame += shared->frameCycles;
+        frames++;
+    }
+
+    if (shared->framesPerSecond) {
+        uint64_t due = shared->startTime + frames * 1000000000ULL / shared->framesPerSecond;
+        uint64_t current = now();
+        if (due > current) {
+            struct timespec delay = { (time_t) ((due - current) / 1000000000ULL), (long) ((due - current) % 1000000000ULL) };
+            nanosleep(&delay, NULL);
+        }
+    }
+
+    header->cycles = cpu->cycles;
+    __atomic_store_n(&header->frameSequence, frames, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Records the final state, gives the CPU its own RAM back and unlinks the object
+ *
+ * @param shared Pointer to the export state
+ * @param cpu Pointer to the CPU
+ * @param state SHARED_HALTED or SHARED_STOPPED
+ */
+void closeSharedMemory(SharedMemory * shared, CPU * cpu, uint32_t state) {
+    if (shared->header == NULL) {
+        return;
+    }
+
+    memcpy(shared->privateRam, cpu->ram, RAM_SIZE * sizeof(uint16_t));
+    cpu->ram = shared->privateRam;
+
+    shared->header->cycles = cpu->cycles;
+    shared->header->state = state;
+    __atomic_store_n(&shared->header->frameSequence, shared->header->frameSequence + 1, __ATOMIC_RELEASE);
+
+    munmap(shared->header, SHARED_MEMORY_SIZE);
+    shm_unlink(shared->name);
+    free(shared->name);
+    memset(shared, 0, sizeof(SharedMemory));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file SharedMemory.h
+ * @brief Shared-memory export of the Hack RAM for external viewers
+ *
+ * With --shm NAME the emulator creates the POSIX shared-memory object NAME
+ * and runs the program directly on a RAM that lives inside it, so a viewer
+ * or test tool in another process sees SCREEN and KBD without any copying
+ * and can press keys by storing into KBD. The object starts with a
+ * SharedHeader followed by the RAM_SIZE words of RAM. Like CPU.h this header
+ * only depends on system headers, so viewers can include it on its own.
+ *
+ * A viewer opens the object with shm_open(NAME, O_RDWR, 0) and maps
+ * SHARED_MEMORY_SIZE bytes. The emulator bumps frameSequence (with release
+ * semantics) every time it finishes a frame of frameCycles instructions;
+ * a viewer polls it with acquire loads and redraws when it changes.
+ */
+
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "CPU.h"
+
+// Layout Identification
+#define SHARED_MAGIC        0x4B434148u     // "HACK" in little-endian byte order
+#define SHARED_VERSION      1
+
+// Emulator States
+#define SHARED_RUNNING      0
+#define SHARED_HALTED       1
+#define SHARED_STOPPED      2
+
+/**
+ * @brief Header at the start of the shared-memory object
+ */
+typedef struct SharedHeader {
+    uint32_t magic;             // SHARED_MAGIC
+    uint32_t version;           // SHARED_VERSION
+    uint32_t ramOffset;         // Byte offset of RAM[0] from the start of the object
+    uint32_t ramWords;          // RAM_SIZE
+    uint32_t screenAddress;     // RAM_SCREEN
+    uint32_t keyboardAddress;   // RAM_KBD
+    uint32_t state;             // SHARED_RUNNING, SHARED_HALTED or SHARED_STOPPED
+    uint32_t frameCycles;       // Instructions per frame
+    uint64_t frameSequence;     // Number of completed frames
+    uint64_t cycles;            // Instructions executed at the last frame
+    uint8_t reserved[16];
+} SharedHeader;
+
+// Size of the shared-memory object
+#define SHARED_MEMORY_SIZE  (sizeof(SharedHeader) + RAM_SIZE * sizeof(uint16_t))
+
+/**
+ * @brief Emulator-side state of the shared-memory export
+ */
+typedef struct SharedMemory {
+    char * name;
+    SharedHeader * header;
+    uint16_t * privateRam;      // The CPU's own RAM, restored when the export closes
+    uint64_t frameCycles;
+    uint64_t nextFrame;         // Cycle at which the next frame completes
+    uint64_t framesPerSecond;   // Wall-clock pacing, or 0 to run unthrottled
+    uint64_t startTime;         // Monotonic nanoseconds when pacing started
+} SharedMemory;
+
+/**
+ * @brief Creates the shared-memory object and moves the CPU's RAM into it
+ *
+ * @param shared Pointer to the export state to initialize
+ * @param cpu Pointer to the CPU whose RAM is shared
+ * @param name Name of the POSIX shared-memory object (for example "/hack")
+ * @param frameCycles Instructions per frame
+ * @param framesPerSecond Frames per wall-clock second, or 0 for no pacing
+ * @return true on success, false on errors
+ */
+bool openSharedMemory(SharedMemory * shared, CPU * cpu, const char * name, uint64_t frameCycles, uint64_t framesPerSecond);
+
+/**
+ * @brief Publishes every frame completed by the current cycle count
+ *
+ * Sleeps first when pacing is enabled and the emulator is ahead of the
+ * wall clock.
+ *
+ * @param shared Pointer to the export state
+ * @param cpu Pointer to the CPU
+ */
+void publishFrame(SharedMemory * shared, const CPU * cpu);
+
+/**
+ * @brief Records the final state, gives the CPU its own RAM back and unlinks the object
+ *
+ * Viewers that still have the object mapped keep seeing the final frame.
+ *
+ * @param shared Pointer to the export state
+ * @param cpu Pointer to the CPU
+ * @param state SHARED_HALTED or SHARED_STOPPED
+ */
+void closeSharedMemory(SharedMemory * shared, CPU * cpu, uint32_t state);
+
+#endif
@@ -0,0 +1,635 @@
+/**
+ * @file Trace.c
+ * @brief Compact execution traces for the native Hack Emulator
+ *
+ * The recorder observes every instruction: conditional jumps append one bit
+ * and reads of KBD append an input event when the value differs from the
+ * last one seen. RAM writes are not logged one by one; at the end of each
+ * chunk the RAM is compared with a copy taken at its start and only the
+ * words that changed are encoded, which coalesces the many writes to the
+ * same stack and local slots into one record per word. The replayer reads
+ * the same format back.
+ */
+
+#include "Trace.h"
+
+/**
+ * @brief The decoded contents of one trace chunk
+ */
+typedef struct Chunk {
+    uint64_t start;             // Cycle at which the chunk starts
+    uint64_t cycles;            // Cycles covered by the chunk
+    uint16_t a;
+    uint16_t d;
+    uint16_t pc;
+    uint64_t * inputCycles;
+    uint16_t * inputValues;
+    size_t inputCount;
+    size_t inputCapacity;
+    uint8_t * branches;
+    size_t branchCount;
+    size_t branchCapacity;      // In bytes
+    uint16_t * writeAddresses;
+    uint16_t * writeValues;     // Value deltas, added modulo 2^16
+    size_t writeCount;
+    size_t writeCapacity;
+} Chunk;
+
+/**
+ * @brief Makes room for extra bytes at the end of a buffer
+ *
+ * @param buffer Pointer to the buffer
+ * @param extra Number of bytes to make room for
+ * @return true on success, false if allocation failed
+ */
+static bool reserveBytes(ByteBuffer * buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) {
+        return true;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    uint8_t * data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Appends an unsigned LEB128 varint
+ *
+ * @param buffer Pointer to the buffer
+ * @param value The value to encode
+ * @return true on success, false if allocation failed
+ */
+static bool putVarint(ByteBuffer * buffer, uint64_t value) {
+    if (!reserveBytes(buffer, 10)) {
+        return false;
+    }
+    while (value >= 0x80) {
+        buffer->data[buffer->length++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    buffer->data[buffer->length++] = (uint8_t) value;
+    return true;
+}
+
+/**
+ * @brief Appends raw bytes
+ *
+ * @param buffer Pointer to the buffer
+ * @param data The bytes to append
+ * @param length Number of bytes
+ * @return true on success, false if allocation failed
+ */
+static bool putBytes(ByteBuffer * buffer, const void * data, size_t length) {
+    if (!reserveBytes(buffer, length)) {
+        return false;
+    }
+    if (length > 0) {
+        memcpy(buffer->data + buffer->length, data, length);
+    }
+    buffer->length += length;
+    return true;
+}
+
+/**
+ * @brief Maps a signed 16-bit delta to an unsigned value, small magnitudes first
+ */
+static inline uint64_t zigzag(uint16_t delta) {
+    int16_t value = (int16_t) delta;
+    return (uint64_t) (uint16_t) ((value << 1) ^ (value >> 15));
+}
+
+/**
+ * @brief Inverts zigzag
+ */
+static inline uint16_t unzigzag(uint64_t value) {
+    return (uint16_t) ((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/**
+ * @brief Computes a checksum of the loaded program (64-bit FNV-1a)
+ */
+static uint64_t romChecksum(const CPU * cpu) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (uint32_t i = 0; i < cpu->romLength; i++) {
+        hash = (hash ^ (cpu->rom[i] & 0xFF)) * 0x100000001B3ULL;
+        hash = (hash ^ (cpu->rom[i] >> 8)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Decides whether a C-instruction with a conditional jump jumps
+ *
+ * @param cpu Pointer to the CPU, before the instruction executes
+ * @param instruction The C-instruction
+ * @return true if the jump is taken
+ */
+static inline bool jumpTaken(const CPU * cpu, uint16_t instruction) {
+    uint16_t y = (instruction & 0x1000) ? cpu->ram[cpu->a & RAM_MASK] : cpu->a;
+    int16_t out = (int16_t) cpuCompute(instruction, cpu->d, y);
+    return ((instruction & 0x4) && out < 0) || ((instruction & 0x2) && out == 0) || ((instruction & 0x1) && out > 0);
+}
+
+/**
+ * @brief Tells whether an instruction is a C-instruction with a conditional jump
+ */
+static inline bool isConditional(uint16_t instruction) {
+    uint16_t jump = instruction & 0x7;
+    return (instruction & 0x8000) && jump != 0 && jump != 7;
+}
+
+/**
+ * @brief Writes the buffered encoded chunks to the trace file
+ *
+ * @param trace Pointer to the recorder
+ */
+static void flushTrace(Trace * trace) {
+    if (trace->output.length > 0 && fwrite(trace->output.data, 1, trace->output.length, trace->file) != trace->output.length) {
+        trace->failed = true;
+    }
+    trace->bytes += trace->output.length;
+    trace->output.length = 0;
+}
+
+/**
+ * @brief Encodes the current chunk and starts the next one at the CPU's state
+ *
+ * @param trace Pointer to the recorder
+ * @param cpu Pointer to the CPU
+ */
+static void endChunk(Trace * trace, const CPU * cpu) {
+    ByteBuffer * output = &trace->output;
+    const uint16_t * ram = cpu->ram;
+    uint16_t * base = trace->base;
+
+    size_t writes = 0;
+    for (size_t address = 0; address < RAM_SIZE; address++) {
+        writes += ram[address] != base[address];
+    }
+
+    bool success = putBytes(output, "C", 1) &&
+                   putVarint(output, cpu->cycles - trace->chunkStart) &&
+                   putVarint(output, trace->startA) &&
+                   putVarint(output, trace->startD) &&
+                   putVarint(output, trace->startPC) &&
+                   putVarint(output, trace->inputCount) &&
+                   putBytes(output, trace->inputs.data, trace->inputs.length) &&
+                   putVarint(output, trace->branchCount) &&
+                   putBytes(output, trace->branches.data, trace->branches.length) &&
+                   putVarint(output, writes);
+
+    size_t next = 0;
+    for (size_t address = 0; success && address < RAM_SIZE; address++) {
+        if (ram[address] != base[address]) {
+            success = putVarint(output, address - next) &&
+                      putVarint(output, zigzag((uint16_t) (ram[address] - base[address])));
+            base[address] = ram[address];
+            next = address + 1;
+        }
+    }
+    if (!success) {
+        trace->failed = true;
+    }
+
+    trace->chunks++;
+    trace->totalBranches += trace->branchCount;
+    trace->totalWrites += writes;
+    trace->chunkStart = cpu->cycles;
+    trace->lastInput = cpu->cycles;
+    trace->startA = cpu->a;
+    trace->startD = cpu->d;
+    trace->startPC = cpu->pc;
+    trace->inputs.length = 0;
+    trace->inputCount = 0;
+    trace->branches.length = 0;
+    trace->branchCount = 0;
+
+    if (output->length >= TRACE_FLUSH_SIZE) {
+        flushTrace(trace);
+    }
+}
+
+/**
+ * @brief Creates a trace file and starts recording at the CPU's current state
+ *
+ * The first chunk's writes are relative to zeroed RAM, so a replay can
+ * start from a freshly reset machine.
+ *
+ * @param trace Pointer to the recorder to initialize
+ * @param cpu Pointer to the CPU, freshly reset with its program loaded
+ * @param path Path of the trace file
+ * @param chunkCycles Cycles per chunk
+ * @return true on success, false on I/O or allocation errors
+ */
+bool startTrace(Trace * trace, const CPU * cpu, const char * path, uint64_t chunkCycles) {
+    memset(trace, 0, sizeof(Trace));
+    trace->base = calloc(RAM_SIZE, sizeof(uint16_t));
+    trace->file = fopen(path, "wb");
+    if (trace->base == NULL || trace->file == NULL) {
+        fprintf(stderr, "Error: Failed to open trace file %s\n", path);
+        free(trace->base);
+        if (trace->file != NULL) {
+            fclose(trace->file);
+        }
+        return false;
+    }
+
+    trace->chunkCycles = chunkCycles;
+    trace->chunkStart = cpu->cycles;
+    trace->lastInput = cpu->cycles;
+    trace->startA = cpu->a;
+    trace->startD = cpu->d;
+    trace->startPC = cpu->pc;
+
+    if (!putBytes(&trace->output, TRACE_MAGIC, 4) ||
+        !putVarint(&trace->output, TRACE_VERSION) ||
+        !putVarint(&trace->output, cpu->romLength) ||
+        !putVarint(&trace->output, romChecksum(cpu)) ||
+        !putVarint(&trace->output, chunkCycles)) {
+        trace->failed = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Executes instructions like cpuRun while recording them
+ *
+ * @param trace Pointer to the recorder
+ * @param cpu Pointer to the CPU
+ * @param limit Cycle count at which to stop (0 for no limit)
+ * @return CPU_LIMIT, CPU_BREAK or CPU_HALT
+ */
+int traceRun(Trace * trace, CPU * cpu, uint64_t limit) {
+    const uint16_t * rom = cpu->rom;
+    const uint8_t * breakpoints = cpu->breakpoints;
+
+    for (;;) {
+        if (limit && cpu->cycles >= limit) {
+            return CPU_LIMIT;
+        }
+        if (cpu->cycles - trace->chunkStart >= trace->chunkCycles) {
+            endChunk(trace, cpu);
+        }
+
+        uint16_t instruction = rom[cpu->pc];
+        if (instruction & 0x8000) {
+            if ((instruction & 0x1000) && (cpu->a & RAM_MASK) == RAM_KBD && cpu->ram[RAM_KBD] != trace->keyboard) {
+                trace->keyboard = cpu->ram[RAM_KBD];
+                if (!putVarint(&trace->inputs, cpu->cycles - trace->lastInput) ||
+                    !putVarint(&trace->inputs, trace->keyboard)) {
+                    trace->failed = true;
+                }
+                trace->lastInput = cpu->cycles;
+                trace->inputCount++;
+            }
+
+            if (isConditional(instruction)) {
+                if ((trace->branchCount & 7) == 0 && !putBytes(&trace->branches, "", 1)) {
+                    trace->failed = true;
+                    return CPU_LIMIT;
+                }
+                if (jumpTaken(cpu, instruction)) {
+                    trace->branches.data[trace->branchCount >> 3] |= (uint8_t) (1 << (trace->branchCount & 7));
+                }
+                trace->branchCount++;
+            }
+        }
+
+        if (cpuStep(cpu)) {
+            return CPU_HALT;
+        }
+        if (breakpoints[cpu->pc]) {
+            return CPU_BREAK;
+        }
+    }
+}
+
+/**
+ * @brief Writes the last partial chunk and closes the trace file
+ *
+ * @param trace Pointer to the recorder
+ * @param cpu Pointer to the CPU
+ * @param summary Stream receiving a size summary, or NULL
+ * @return true on success, false on I/O errors
+ */
+bool stopTrace(Trace * trace, const CPU * cpu, FILE * summary) {
+    if (cpu->cycles > trace->chunkStart) {
+        endChunk(trace, cpu);
+    }
+    if (!putBytes(&trace->output, "E", 1) || !putVarint(&trace->output, cpu->a) ||
+        !putVarint(&trace->output, cpu->d) || !putVarint(&trace->output, cpu->pc)) {
+        trace->failed = true;
+    }
+    flushTrace(trace);
+    if (fclose(trace->file) != 0) {
+        trace->failed = true;
+    }
+
+    bool success = !trace->failed;
+    if (!success) {
+        fprintf(stderr, "Error: Failed to write the trace file\n");
+    } else if (summary != NULL) {
+        fprintf(summary, "Trace: %llu chunks, %llu branches, %llu changed words, %llu bytes (%.3f bits per cycle)\n",
+                (unsigned long long) trace->chunks, (unsigned long long) trace->totalBranches,
+                (unsigned long long) trace->totalWrites, (unsigned long long) trace->bytes,
+                cpu->cycles ? 8.0 * (double) trace->bytes / (double) cpu->cycles : 0.0);
+    }
+
+    free(trace->output.data);
+    free(trace->inputs.data);
+    free(trace->branches.data);
+    free(trace->base);
+    memset(trace, 0, sizeof(Trace));
+    return success;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint
+ *
+ * @param file The trace file
+ * @param value Receives the decoded value
+ * @return true on success, false at the end of the file or on malformed input
+ */
+static bool getVarint(FILE * file, uint64_t * value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = getc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        result |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Grows one or two parallel arrays to hold at least count elements
+ *
+ * @param first Pointer to the first array
+ * @param firstSize Element size of the first array
+ * @param second Pointer to the second array, or NULL
+ * @param secondSize Element size of the second array
+ * @param capacity Pointer to the shared capacity
+ * @param count Number of elements needed
+ * @return true on success, false if allocation failed
+ */
+static bool reserveArrays(void ** first, size_t firstSize, void ** second, size_t secondSize, size_t * capacity, size_t count) {
+    if (count <= *capacity) {
+        return true;
+    }
+    void * grown = realloc(*first, count * firstSize);
+    if (grown == NULL) {
+        return false;
+    }
+    *first = grown;
+    if (second != NULL) {
+        grown = realloc(*second, count * secondSize);
+        if (grown == NULL) {
+            return false;
+        }
+        *second = grown;
+    }
+    *capacity = count;
+    return true;
+}
+
+/**
+ * @brief Reads the next chunk of a trace
+ *
+ * The end record only carries the final registers, which are stored in the
+ * chunk's a, d and pc fields.
+ *
+ * @param file The trace file, positioned at a chunk
+ * @param chunk Pointer to the chunk to fill; its arrays are reused
+ * @param start Cycle at which the chunk starts
+ * @return 1 on success, 0 at the end record, -1 on malformed input
+ */
+static int readChunk(FILE * file, Chunk * chunk, uint64_t start) {
+    int tag = getc(file);
+    uint64_t a, d, pc, count, value;
+    if (tag == 'E') {
+        if (!getVarint(file, &a) || !getVarint(file, &d) || !getVarint(file, &pc)) {
+            return -1;
+        }
+        chunk->a = (uint16_t) a;
+        chunk->d = (uint16_t) d;
+        chunk->pc = (uint16_t) pc;
+        return 0;
+    }
+
+    if (tag != 'C' || !getVarint(file, &chunk->cycles) ||
+        !getVarint(file, &a) || !getVarint(file, &d) || !getVarint(file, &pc) || !getVarint(file, &count)) {
+        return -1;
+    }
+    chunk->start = start;
+    chunk->a = (uint16_t) a;
+    chunk->d = (uint16_t) d;
+    chunk->pc = (uint16_t) pc;
+
+    if (count > chunk->cycles ||
+        !reserveArrays((void **) &chunk->inputCycles, sizeof(uint64_t), (void **) &chunk->inputValues, sizeof(uint16_t),
+                       &chunk->inputCapacity, count)) {
+        return -1;
+    }
+    uint64_t cycle = start;
+    for (size_t i = 0; i < count; i++) {
+        if (!getVarint(file, &value)) {
+            return -1;
+        }
+        cycle += value;
+        chunk->inputCycles[i] = cycle;
+        if (!getVarint(file, &value)) {
+            return -1;
+        }
+        chunk->inputValues[i] = (uint16_t) value;
+    }
+    chunk->inputCount = count;
+
+    if (!getVarint(file, &count) || count > chunk->cycles ||
+        !reserveArrays((void **) &chunk->branches, 1, NULL, 0, &chunk->branchCapacity, (count + 7) / 8) ||
+        fread(chunk->branches, 1, (count + 7) / 8, file) != (count + 7) / 8) {
+        return -1;
+    }
+    chunk->branchCount = count;
+
+    if (!getVarint(file, &count) || count > RAM_SIZE ||
+        !reserveArrays((void **) &chunk->writeAddresses, sizeof(uint16_t), (void **) &chunk->writeValues, sizeof(uint16_t),
+                       &chunk->writeCapacity, count)) {
+        return -1;
+    }
+    uint64_t address = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!getVarint(file, &value)) {
+            return -1;
+        }
+        address += value;
+        if (address >= RAM_SIZE || !getVarint(file, &value)) {
+            return -1;
+        }
+        chunk->writeAddresses[i] = (uint16_t) address;
+        chunk->writeValues[i] = unzigzag(value);
+        address++;
+    }
+    chunk->writeCount = count;
+    return 1;
+}
+
+/**
+ * @brief Re-executes part of a chunk, checking every branch outcome
+ *
+ * @param cpu Pointer to the CPU, at the chunk's start state
+ * @param chunk The chunk being replayed
+ * @param stop Cycle at which to stop
+ * @return true on success, false if the re-execution diverges from the trace
+ */
+static bool executeChunk(CPU * cpu, const Chunk * chunk, uint64_t stop) {
+    size_t input = 0;
+    size_t branch = 0;
+
+    while (cpu->cycles < stop) {
+        while (input < chunk->inputCount && chunk->inputCycles[input] == cpu->cycles) {
+            cpu->ram[RAM_KBD] = chunk->inputValues[input++];
+        }
+
+        uint16_t instruction = cpu->rom[cpu->pc];
+        if (isConditional(instruction)) {
+            bool taken = jumpTaken(cpu, instruction);
+            if (branch >= chunk->branchCount || taken != ((chunk->branches[branch >> 3] >> (branch & 7)) & 1)) {
+                fprintf(stderr, "Error: Replay diverged at cycle %llu: the jump at PC %u was %s when recorded\n",
+                        (unsigned long long) cpu->cycles, cpu->pc, taken ? "not taken" : "taken");
+                return false;
+            }
+            branch++;
+        }
+        cpuStep(cpu);
+    }
+    return true;
+}
+
+/**
+ * @brief Frees the arrays of a chunk
+ */
+static void cleanupChunk(Chunk * chunk) {
+    free(chunk->inputCycles);
+    free(chunk->inputValues);
+    free(chunk->branches);
+    free(chunk->writeAddresses);
+    free(chunk->writeValues);
+}
+
+/**
+ * @brief Rebuilds the machine state at a cycle by replaying a trace
+ *
+ * RAM is rebuilt from the write deltas of every chunk before the target
+ * cycle; only the chunk containing the target is re-executed (every chunk
+ * with verify).
+ *
+ * @param cpu Pointer to the CPU
+ * @param path Path of the trace file
+ * @param cycle Cycle to stop at (0 for the end of the trace)
+ * @param verify Re-execute the whole trace up to the cycle
+ * @return true on success, false on I/O errors or if re-execution diverges
+ */
+bool replayTrace(CPU * cpu, const char * path, uint64_t cycle, bool verify) {
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open trace file %s\n", path);
+        return false;
+    }
+
+    char magic[4];
+    uint64_t version, romLength, checksum, chunkCycles;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, TRACE_MAGIC, 4) != 0 ||
+        !getVarint(file, &version) || version != TRACE_VERSION ||
+        !getVarint(file, &romLength) || !getVarint(file, &checksum) || !getVarint(file, &chunkCycles)) {
+        fprintf(stderr, "Error: %s is not a trace file\n", path);
+        fclose(file);
+        return false;
+    }
+    if (romLength != cpu->romLength || checksum != romChecksum(cpu)) {
+        fprintf(stderr, "Error: %s was recorded from a different program\n", path);
+        fclose(file);
+        return false;
+    }
+
+    uint16_t * expected = calloc(RAM_SIZE, sizeof(uint16_t));
+    if (expected == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    resetCPU(cpu);
+    Chunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    uint64_t start = 0;
+    bool success = true;
+    int status;
+
+    while ((status = readChunk(file, &chunk, start)) > 0) {
+        uint64_t end = start + chunk.cycles;
+        bool target = cycle != 0 && cycle < end;
+
+        if (verify || target) {
+            // KBD is input rather than computed state; it may change without being read
+            cpu->ram[RAM_KBD] = expected[RAM_KBD];
+            if (verify && (cpu->a != chunk.a || cpu->d != chunk.d || cpu->pc != chunk.pc ||
+                           memcmp(cpu->ram, expected, RAM_SIZE * sizeof(uint16_t)) != 0)) {
+                fprintf(stderr, "Error: Replay diverged before cycle %llu\n", (unsigned long long) start);
+                success = false;
+                break;
+            }
+            memcpy(cpu->ram, expected, RAM_SIZE * sizeof(uint16_t));
+            cpu->a = chunk.a;
+            cpu->d = chunk.d;
+            cpu->pc = chunk.pc;
+            cpu->cycles = start;
+            if (!executeChunk(cpu, &chunk, target ? cycle : end)) {
+                success = false;
+                break;
+            }
+            if (target) {
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < chunk.writeCount; i++) {
+            expected[chunk.writeAddresses[i]] += chunk.writeValues[i];
+        }
+        start = end;
+    }
+
+    if (status < 0) {
+        fprintf(stderr, "Error: %s is truncated or corrupt\n", path);
+        success = false;
+    } else if (success && (status == 0 || cycle == 0)) {
+        // The end of the trace: the state after the last chunk
+        cpu->ram[RAM_KBD] = expected[RAM_KBD];
+        if (verify && (cpu->a != chunk.a || cpu->d != chunk.d || cpu->pc != chunk.pc ||
+                       memcmp(cpu->ram, expected, RAM_SIZE * sizeof(uint16_t)) != 0)) {
+            fprintf(stderr, "Error: Replay diverged before cycle %llu\n", (unsigned long long) start);
+            success = false;
+        }
+        memcpy(cpu->ram, expected, RAM_SIZE * sizeof(uint16_t));
+        cpu->a = chunk.a;
+        cpu->d = chunk.d;
+        cpu->pc = chunk.pc;
+        cpu->cycles = start;
+    }
+
+    cleanupChunk(&chunk);
+    free(expected);
+    fclose(file);
+    return success;
+}
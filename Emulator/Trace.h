@@ -0,0 +1,116 @@
+/**
+ * @file Trace.h
+ * @brief Compact execution traces for the native Hack Emulator
+ *
+ * Hack execution is deterministic except for the keyboard, so a trace only
+ * needs enough information to re-execute the ROM and to check that the
+ * re-execution follows the recorded run. The trace is a stream of chunks,
+ * each covering a fixed number of cycles and holding:
+ *
+ * - the A, D and PC registers at the start of the chunk,
+ * - the KBD values seen by the program, with the cycle of each change,
+ * - one bit per executed conditional jump (taken or not),
+ * - the RAM words the chunk changed, as address and value deltas against
+ *   the state at the start of the chunk.
+ *
+ * All numbers are LEB128 varints (signed deltas zigzag-encoded), and chunks
+ * are streamed through a buffered writer. The replayer rebuilds RAM at any
+ * chunk boundary by applying the write deltas, then re-executes the ROM up
+ * to the requested cycle, checking every branch outcome on the way.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Config.h"
+#include "CPU.h"
+
+// File Identification
+#define TRACE_MAGIC         "HKTR"
+#define TRACE_VERSION       1
+
+/**
+ * @brief A growable byte buffer
+ */
+typedef struct ByteBuffer {
+    uint8_t * data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+/**
+ * @brief Trace recorder state
+ */
+typedef struct Trace {
+    FILE * file;
+    ByteBuffer output;          // Encoded chunks not yet written to the file
+    ByteBuffer inputs;          // Encoded KBD changes of the current chunk
+    ByteBuffer branches;        // Branch outcome bits of the current chunk
+    uint16_t * base;            // RAM at the start of the current chunk
+    uint64_t chunkCycles;
+    uint64_t chunkStart;        // Cycle at which the current chunk started
+    uint64_t lastInput;         // Cycle of the previous KBD change in this chunk
+    size_t inputCount;
+    size_t branchCount;
+    uint16_t startA;
+    uint16_t startD;
+    uint16_t startPC;
+    uint16_t keyboard;          // Last KBD value seen by the program
+    uint64_t bytes;             // Bytes written so far
+    uint64_t chunks;
+    uint64_t totalBranches;
+    uint64_t totalWrites;
+    bool failed;                // An allocation or write failed
+} Trace;
+
+/**
+ * @brief Creates a trace file and starts recording at the CPU's current state
+ *
+ * @param trace Pointer to the recorder to initialize
+ * @param cpu Pointer to the CPU, freshly reset with its program loaded
+ * @param path Path of the trace file
+ * @param chunkCycles Cycles per chunk
+ * @return true on success, false on I/O or allocation errors
+ */
+bool startTrace(Trace * trace, const CPU * cpu, const char * path, uint64_t chunkCycles);
+
+/**
+ * @brief Executes instructions like cpuRun while recording them
+ *
+ * Loop counting is not supported; the run stops at the limit, breakpoints
+ * and halt loops only.
+ *
+ * @param trace Pointer to the recorder
+ * @param cpu Pointer to the CPU
+ * @param limit Cycle count at which to stop (0 for no limit)
+ * @return CPU_LIMIT, CPU_BREAK or CPU_HALT
+ */
+int traceRun(Trace * trace, CPU * cpu, uint64_t limit);
+
+/**
+ * @brief Writes the last partial chunk and closes the trace file
+ *
+ * @param trace Pointer to the recorder
+ * @param cpu Pointer to the CPU
+ * @param summary Stream receiving a size summary, or NULL
+ * @return true on success, false on I/O errors
+ */
+bool stopTrace(Trace * trace, const CPU * cpu, FILE * summary);
+
+/**
+ * @brief Rebuilds the machine state at a cycle by replaying a trace
+ *
+ * The CPU must have the traced program loaded. On success the CPU holds the
+ * complete state (registers and RAM) at the requested cycle, or at the end
+ * of the trace if it is shorter. With verify, every chunk is re-executed
+ * rather than skipped and its RAM is compared with the recorded writes.
+ *
+ * @param cpu Pointer to the CPU
+ * @param path Path of the trace file
+ * @param cycle Cycle to stop at (0 for the end of the trace)
+ * @param verify Re-execute the whole trace up to the cycle
+ * @return true on success, false on I/O errors or if re-execution diverges
+ */
+bool replayTrace(CPU * cpu, const char * path, uint64_t cycle, bool verify);
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * @file TraceReplay.c
+ * @brief Replayer for traces recorded with Emulator --trace
+ *
+ * This file contains the entry point of TraceReplay, which rebuilds the
+ * complete machine state of a recorded run at any cycle by re-executing the
+ * program's ROM against the trace (see Trace.h), and prints the registers,
+ * a RAM range or the screen at that point.
+ */
+
+#include "Config.h"
+#include "CPU.h"
+#include "Framebuffer.h"
+#include "Loader.h"
+#include "Trace.h"
+
+/**
+ * @brief Command line options
+ */
+typedef struct Options {
+    const char * traceName;
+    const char * programName;
+    const char * screenshotName;
+    uint64_t cycle;
+    bool verify;
+    long dumpStart;
+    long dumpEnd;
+} Options;
+
+/**
+ * @brief Prints command line usage
+ */
+static void printUsage(void) {
+    fprintf(stderr,
+            "Usage: TraceReplay [OPTIONS] TRACE FILE.hack\n"
+            "  --cycle N            Rebuild the state at cycle N (default: the end of the trace)\n"
+            "  --verify             Re-execute the whole trace and check it against the recorded writes\n"
+            "  --screenshot FILE    Save the screen at that cycle (.pam for RGBA, otherwise PGM)\n"
+            "  --dump A:B           Print RAM[A..B] at that cycle\n");
+}
+
+/**
+ * @brief Parses command line arguments
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param options Pointer to the options to fill
+ * @return true on success, false if usage should be printed
+ */
+static bool parseArguments(int argc, char * argv[], Options * options) {
+    memset(options, 0, sizeof(Options));
+    options->dumpStart = -1;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--cycle") == 0 && hasValue) {
+            options->cycle = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            options->verify = true;
+        } else if (strcmp(argv[i], "--screenshot") == 0 && hasValue) {
+            options->screenshotName = argv[++i];
+        } else if (strcmp(argv[i], "--dump") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%ld:%ld", &options->dumpStart, &options->dumpEnd) != 2 ||
+                options->dumpStart < 0 || options->dumpEnd < options->dumpStart ||
+                options->dumpEnd >= RAM_SIZE) {
+                fprintf(stderr, "Error: Invalid dump range %s\n", argv[i]);
+                return false;
+            }
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else if (options->traceName == NULL) {
+            options->traceName = argv[i];
+        } else if (options->programName == NULL) {
+            options->programName = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return options->programName != NULL;
+}
+
+/**
+ * @brief Main entry point for the trace replayer
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return 0 on success, 1 on error or divergence
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    CPU cpu;
+    if (!initCPU(&cpu)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+
+    int status = 1;
+    if (loadProgram(&cpu, options.programName) &&
+        replayTrace(&cpu, options.traceName, options.cycle, options.verify)) {
+        printf("Cycle %llu: PC = %u, A = %d, D = %d\n", (unsigned long long) cpu.cycles,
+               cpu.pc, (int16_t) cpu.a, (int16_t) cpu.d);
+        for (long address = options.dumpStart; options.dumpStart >= 0 && address <= options.dumpEnd; address++) {
+            printf("RAM[%ld] = %d\n", address, (int16_t) cpu.ram[address]);
+        }
+        status = 0;
+        if (options.screenshotName != NULL && !writeScreenshot(cpu.ram + RAM_SCREEN, options.screenshotName)) {
+            status = 1;
+        }
+    }
+
+    cleanupCPU(&cpu);
+    return status;
+}
@@ -16,6 +16,13 @@ static int ltCounter = 0;
 static int returnCounter = 0;
 static char curr[MAX_FILENAME_LENGTH] = "";
 static char currFunction[MAX_FILENAME_LENGTH] = "";
+static bool returnRoutineUsed = false;
+static bool returnRoutineWritten = false;
+static LabelMap * labelMap = NULL;
+static const char * knownBase = NULL;
+static int knownIndex = 0;
+
+static void writeReturnRoutine(FILE * outputFile);
 
 /**
  * @brief Sets the current VM file name for static variable naming
@@ -35,20 +42,103 @@ void setFunction(const char * functionName) {
     strcpy(currFunction, functionName);
 }
 
+/**
+ * @brief Switches generated symbols to the short names of a label map
+ * 
+ * @param map The label map assigning short names, or NULL for full names
+ */
+void setLabelMap(LabelMap * map) {
+    labelMap = map;
+}
+
+/**
+ * @brief Returns the name to emit for a generated symbol
+ * 
+ * With a label map the symbol is replaced by its short name. The result,
+ * like those of the helpers below, stays valid until their next call.
+ * 
+ * @param name The full symbol name
+ * @return The name to write to the assembly output
+ */
+static const char * symbolName(const char * name) {
+    static char shortName[MAX_SHORT_LABEL_LENGTH];
+    if (labelMap == NULL) {
+        return name;
+    }
+    if (!shortLabel(labelMap, name, shortName)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(1);
+    }
+    return shortName;
+}
+
+/**
+ * @brief Returns the name to emit for a numbered label such as "RETURN12"
+ * 
+ * @param prefix The label prefix
+ * @param counter The label number
+ * @return The name to write to the assembly output
+ */
+static const char * numberedLabel(const char * prefix, int counter) {
+    static char name[MAX_ARG_LENGTH];
+    snprintf(name, sizeof(name), "%s%d", prefix, counter);
+    return symbolName(name);
+}
+
+/**
+ * @brief Returns the name to emit for a VM label, scoped by its function
+ * 
+ * @param label The label as written in the VM code
+ * @return The name to write to the assembly output
+ */
+static const char * scopedLabel(const char * label) {
+    static char name[MAX_FILENAME_LENGTH + MAX_ARG_LENGTH];
+    if (strlen(currFunction) == 0) {
+        return symbolName(label);
+    }
+    snprintf(name, sizeof(name), "%s$%s", currFunction, label);
+    return symbolName(name);
+}
+
+/**
+ * @brief Returns the name to emit for a static variable of the current file
+ * 
+ * @param index The static segment index
+ * @return The name to write to the assembly output
+ */
+static const char * staticName(const char * index) {
+    static char name[MAX_FILENAME_LENGTH + MAX_ARG_LENGTH];
+    snprintf(name, sizeof(name), "%s.%s", curr, index);
+    return symbolName(name);
+}
+
 /**
  * @brief Writes VM initialization code to assembly output
  * 
- * Generates assembly code to initialize the stack pointer to address 256
- * and calls the Sys.init function to start program execution.
+ * Generates assembly code that stores the heap bounds as the two arguments
+ * of Sys.init at the stack base, sets the stack pointer just above them and
+ * calls Sys.init(heapBase, heapLimit) to start program execution. The
+ * shared return routine follows, where its address is short.
  * 
  * @param outputFile File pointer to the assembly output file
+ * @param memoryMap Layout providing the stack base and the heap bounds
  */
-void writeInit(FILE * outputFile) {
-    fprintf(outputFile, "@256\n");
+void writeInit(FILE * outputFile, const MemoryMap * memoryMap) {
+    knownBase = NULL;
+    fprintf(outputFile, "@%u\n", memoryMap->heapBase);
+    fprintf(outputFile, "D=A\n");
+    fprintf(outputFile, "@%u\n", memoryMap->stackBase);
+    fprintf(outputFile, "M=D\n");
+    fprintf(outputFile, "@%u\n", memoryMap->heapLimit);
+    fprintf(outputFile, "D=A\n");
+    fprintf(outputFile, "@%u\n", memoryMap->stackBase + 1);
+    fprintf(outputFile, "M=D\n");
+    fprintf(outputFile, "@%u\n", memoryMap->stackBase + 2);
     fprintf(outputFile, "D=A\n");
     fprintf(outputFile, "@SP\n");
     fprintf(outputFile, "M=D\n");
-    writeCall(outputFile, "Sys.init", 0);
+    writeCall(outputFile, "Sys.init", 2);
+    writeReturnRoutine(outputFile);
 }
 
 /**
@@ -61,11 +151,8 @@ void writeInit(FILE * outputFile) {
  * @param label The label name to define
  */
 void writeLabel(FILE * outputFile, const char * label) {
-    if (strlen(currFunction) > 0) {
-        fprintf(outputFile, "(%s$%s)\n", currFunction, label);
-    } else {
-        fprintf(outputFile, "(%s)\n", label);
-    }
+    knownBase = NULL;
+    fprintf(outputFile, "(%s)\n", scopedLabel(label));
 }
 
 /**
@@ -78,11 +165,8 @@ void writeLabel(FILE * outputFile, const char * label) {
  * @param label The label to jump to
  */
 void writeGoto(FILE * outputFile, const char * label) {
-    if (strlen(currFunction) > 0) {
-        fprintf(outputFile, "@%s$%s\n", currFunction, label);
-    } else {
-        fprintf(outputFile, "@%s\n", label);
-    }
+    knownBase = NULL;
+    fprintf(outputFile, "@%s\n", scopedLabel(label));
     fprintf(outputFile, "0;JMP\n");
 }
 
@@ -96,14 +180,11 @@ void writeGoto(FILE * outputFile, const char * label) {
  * @param label The label to jump to if condition is true
  */
 void writeIf(FILE * outputFile, const char * label) {
+    knownBase = NULL;
     fprintf(outputFile, "@SP\n");
     fprintf(outputFile, "AM=M-1\n");
     fprintf(outputFile, "D=M\n");
-    if (strlen(currFunction) > 0) {
-        fprintf(outputFile, "@%s$%s\n", currFunction, label);
-    } else {
-        fprintf(outputFile, "@%s\n", label);
-    }
+    fprintf(outputFile, "@%s\n", scopedLabel(label));
     fprintf(outputFile, "D;JNE\n");
 }
 
@@ -119,10 +200,10 @@ void writeIf(FILE * outputFile, const char * label) {
  * @param numArgs The number of arguments passed to the function
  */
 void writeCall(FILE * outputFile, const char * functionName, int numArgs) {
-    char returnLabel[MAX_RETURN_COUNTER];
-    sprintf(returnLabel, "RETURN%d", returnCounter++);
+    knownBase = NULL;
+    int returnIndex = returnCounter++;
     
-    fprintf(outputFile, "@%s\n", returnLabel);
+    fprintf(outputFile, "@%s\n", numberedLabel("RETURN", returnIndex));
     fprintf(outputFile, "D=A\n");
     fprintf(outputFile, "@SP\n");
     fprintf(outputFile, "A=M\n");
@@ -174,29 +255,30 @@ void writeCall(FILE * outputFile, const char * functionName, int numArgs) {
     fprintf(outputFile, "@LCL\n");
     fprintf(outputFile, "M=D\n");
     
-    fprintf(outputFile, "@%s\n", functionName);
+    fprintf(outputFile, "@%s\n", symbolName(functionName));
     fprintf(outputFile, "0;JMP\n");
     
-    fprintf(outputFile, "(%s)\n", returnLabel);
+    fprintf(outputFile, "(%s)\n", numberedLabel("RETURN", returnIndex));
 }
 
 /**
- * @brief Writes function return to assembly output
+ * @brief Writes the shared return routine to assembly output
  * 
- * Generates assembly code for a function return following the Hack calling
- * convention. Restores frame pointers, sets return value, and jumps back
- * to the caller.
+ * Restores the caller's state following the Hack calling convention: the
+ * result is stored at ARG, SP becomes ARG + 1 and THAT, THIS, ARG and LCL
+ * are restored by walking R13 down the frame. On exit R13 holds LCL-4 of
+ * the returning frame, R14 and A the return address and D the restored
+ * LCL.
  * 
  * @param outputFile File pointer to the assembly output file
  */
-void writeReturn(FILE * outputFile) {
+static void writeReturnRoutine(FILE * outputFile) {
+    fprintf(outputFile, "(%s)\n", symbolName(RETURN_ROUTINE));
     fprintf(outputFile, "@LCL\n");
     fprintf(outputFile, "D=M\n");
     fprintf(outputFile, "@R13\n");
     fprintf(outputFile, "M=D\n");
     
-    fprintf(outputFile, "@R13\n");
-    fprintf(outputFile, "D=M\n");
     fprintf(outputFile, "@5\n");
     fprintf(outputFile, "A=D-A\n");
     fprintf(outputFile, "D=M\n");
@@ -210,46 +292,57 @@ void writeReturn(FILE * outputFile) {
     fprintf(outputFile, "A=M\n");
     fprintf(outputFile, "M=D\n");
     
-    fprintf(outputFile, "@ARG\n");
-    fprintf(outputFile, "D=M+1\n");
+    fprintf(outputFile, "D=A+1\n");
     fprintf(outputFile, "@SP\n");
     fprintf(outputFile, "M=D\n");
     
-    fprintf(outputFile, "@R13\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@1\n");
-    fprintf(outputFile, "A=D-A\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@THAT\n");
-    fprintf(outputFile, "M=D\n");
-    
-    fprintf(outputFile, "@R13\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@2\n");
-    fprintf(outputFile, "A=D-A\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@THIS\n");
-    fprintf(outputFile, "M=D\n");
-    
-    fprintf(outputFile, "@R13\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@3\n");
-    fprintf(outputFile, "A=D-A\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@ARG\n");
-    fprintf(outputFile, "M=D\n");
-    
-    fprintf(outputFile, "@R13\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@4\n");
-    fprintf(outputFile, "A=D-A\n");
-    fprintf(outputFile, "D=M\n");
-    fprintf(outputFile, "@LCL\n");
-    fprintf(outputFile, "M=D\n");
+    static const char * const restored[] = {"THAT", "THIS", "ARG", "LCL"};
+    for (int i = 0; i < 4; i++) {
+        fprintf(outputFile, "@R13\n");
+        fprintf(outputFile, "AM=M-1\n");
+        fprintf(outputFile, "D=M\n");
+        fprintf(outputFile, "@%s\n", restored[i]);
+        fprintf(outputFile, "M=D\n");
+    }
     
     fprintf(outputFile, "@R14\n");
     fprintf(outputFile, "A=M\n");
     fprintf(outputFile, "0;JMP\n");
+    returnRoutineWritten = true;
+}
+
+/**
+ * @brief Writes function return to assembly output
+ * 
+ * Every return jumps to one shared return routine instead of repeating
+ * the 41 instructions of the return sequence, which keeps large programs
+ * within the 64K-word ROM. The routine follows the bootstrap, or is
+ * appended by writeEnd when there is no bootstrap.
+ * 
+ * @param outputFile File pointer to the assembly output file
+ */
+void writeReturn(FILE * outputFile) {
+    knownBase = NULL;
+    fprintf(outputFile, "@%s\n", symbolName(RETURN_ROUTINE));
+    fprintf(outputFile, "0;JMP\n");
+    returnRoutineUsed = true;
+}
+
+/**
+ * @brief Writes the code shared by the translated files
+ * 
+ * Appends the shared return routine if a return used it and the bootstrap
+ * did not already provide it.
+ * 
+ * @param outputFile File pointer to the assembly output file
+ * @return The number of labels defined
+ */
+int writeEnd(FILE * outputFile) {
+    if (!returnRoutineUsed || returnRoutineWritten) {
+        return 0;
+    }
+    writeReturnRoutine(outputFile);
+    return 1;
 }
 
 /**
@@ -263,15 +356,14 @@ void writeReturn(FILE * outputFile) {
  * @param numLocals The number of local variables to initialize
  */
 void writeFunction(FILE * outputFile, const char * functionName, int numLocals) {
+    knownBase = NULL;
     setFunction(functionName);
-    fprintf(outputFile, "(%s)\n", functionName);
+    fprintf(outputFile, "(%s)\n", symbolName(functionName));
     
     for (int i = 0; i < numLocals; i++) {
-        fprintf(outputFile, "@0\n");
-        fprintf(outputFile, "D=A\n");
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M\n");
-        fprintf(outputFile, "M=D\n");
+        fprintf(outputFile, "M=0\n");
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "M=M+1\n");
     }
@@ -287,6 +379,7 @@ void writeFunction(FILE * outputFile, const char * functionName, int numLocals)
  * @param command The arithmetic command to translate
  */
 void writeArithmetic(FILE * outputFile, const char * command) {
+    knownBase = NULL;
     if (strcmp(command, "add") == 0) {
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "AM=M-1\n");
@@ -309,18 +402,18 @@ void writeArithmetic(FILE * outputFile, const char * command) {
         fprintf(outputFile, "D=M\n");
         fprintf(outputFile, "A=A-1\n");
         fprintf(outputFile, "D=M-D\n");
-        fprintf(outputFile, "@EQ%d\n", eqCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("EQ", eqCounter));
         fprintf(outputFile, "D;JEQ\n");
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=0\n");
-        fprintf(outputFile, "@EQDONE%d\n", eqCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("EQDONE", eqCounter));
         fprintf(outputFile, "0;JMP\n");
-        fprintf(outputFile, "(EQ%d)\n", eqCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("EQ", eqCounter));
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=-1\n");
-        fprintf(outputFile, "(EQDONE%d)\n", eqCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("EQDONE", eqCounter));
         eqCounter++;
     } else if (strcmp(command, "gt") == 0) {
         fprintf(outputFile, "@SP\n");
@@ -328,18 +421,18 @@ void writeArithmetic(FILE * outputFile, const char * command) {
         fprintf(outputFile, "D=M\n");
         fprintf(outputFile, "A=A-1\n");
         fprintf(outputFile, "D=M-D\n");
-        fprintf(outputFile, "@GT%d\n", gtCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("GT", gtCounter));
         fprintf(outputFile, "D;JGT\n");
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=0\n");
-        fprintf(outputFile, "@GTDONE%d\n", gtCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("GTDONE", gtCounter));
         fprintf(outputFile, "0;JMP\n");
-        fprintf(outputFile, "(GT%d)\n", gtCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("GT", gtCounter));
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=-1\n");
-        fprintf(outputFile, "(GTDONE%d)\n", gtCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("GTDONE", gtCounter));
         gtCounter++;
     } else if (strcmp(command, "lt") == 0) {
         fprintf(outputFile, "@SP\n");
@@ -347,18 +440,18 @@ void writeArithmetic(FILE * outputFile, const char * command) {
         fprintf(outputFile, "D=M\n");
         fprintf(outputFile, "A=A-1\n");
         fprintf(outputFile, "D=M-D\n");
-        fprintf(outputFile, "@LT%d\n", ltCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("LT", ltCounter));
         fprintf(outputFile, "D;JLT\n");
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=0\n");
-        fprintf(outputFile, "@LTDONE%d\n", ltCounter);
+        fprintf(outputFile, "@%s\n", numberedLabel("LTDONE", ltCounter));
         fprintf(outputFile, "0;JMP\n");
-        fprintf(outputFile, "(LT%d)\n", ltCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("LT", ltCounter));
         fprintf(outputFile, "@SP\n");
         fprintf(outputFile, "A=M-1\n");
         fprintf(outputFile, "M=-1\n");
-        fprintf(outputFile, "(LTDONE%d)\n", ltCounter);
+        fprintf(outputFile, "(%s)\n", numberedLabel("LTDONE", ltCounter));
         ltCounter++;
     } else if (strcmp(command, "and") == 0) {
         fprintf(outputFile, "@SP\n");
@@ -381,12 +474,76 @@ void writeArithmetic(FILE * outputFile, const char * command) {
     }
 }
 
+/**
+ * @brief Returns the pointer register holding the base of a segment
+ * 
+ * @param segment The memory segment
+ * @return "LCL", "ARG", "THIS" or "THAT", or NULL for the other segments
+ */
+static const char * segmentBase(const char * segment) {
+    if (strcmp(segment, "local") == 0) {
+        return "LCL";
+    } else if (strcmp(segment, "argument") == 0) {
+        return "ARG";
+    } else if (strcmp(segment, "this") == 0) {
+        return "THIS";
+    } else if (strcmp(segment, "that") == 0) {
+        return "THAT";
+    }
+    return NULL;
+}
+
+/**
+ * @brief Writes code leaving the address of a segment word in A
+ * 
+ * Picks the shortest of three forms: stepping A from the address the
+ * previous command left in it (same segment, no label in between),
+ * stepping from the base with A=M+1 and A=A+1, or adding the index
+ * through D. Only the last form uses D, so callers that hold a value in D
+ * pass allowD = false and must keep the index within the stepping range.
+ * 
+ * @param outputFile File pointer to the assembly output file
+ * @param base The pointer register holding the segment base
+ * @param index The index within the segment
+ * @param allowD Whether D may be overwritten
+ */
+static void writeSegmentAddress(FILE * outputFile, const char * base, int index, bool allowD) {
+    int knownCost = knownBase == base ? abs(index - knownIndex) : INT_MAX;
+    int stepCost = index == 0 ? 2 : index + 1;
+    int generalCost = allowD ? 4 : INT_MAX;
+
+    if (knownCost <= stepCost && knownCost <= generalCost) {
+        for (int i = knownIndex; i < index; i++) {
+            fprintf(outputFile, "A=A+1\n");
+        }
+        for (int i = knownIndex; i > index; i--) {
+            fprintf(outputFile, "A=A-1\n");
+        }
+    } else if (stepCost <= generalCost) {
+        fprintf(outputFile, "@%s\n", base);
+        fprintf(outputFile, index == 0 ? "A=M\n" : "A=M+1\n");
+        for (int i = 1; i < index; i++) {
+            fprintf(outputFile, "A=A+1\n");
+        }
+    } else {
+        fprintf(outputFile, "@%d\n", index);
+        fprintf(outputFile, "D=A\n");
+        fprintf(outputFile, "@%s\n", base);
+        fprintf(outputFile, "A=M+D\n");
+    }
+}
+
 /**
  * @brief Writes push or pop operation to assembly output
  * 
  * Generates assembly code for VM push and pop commands for all memory
  * segments including constant, local, argument, this, that, static,
- * temp, and pointer segments.
+ * temp, and pointer segments. Constants range from -32768 to 65535; 0, 1
+ * and -1 are stored without going through D, other negative values are
+ * loaded with D=-A, and -32768 relies on the assembler's @-32768. Temp words are addressed directly. Words of
+ * local, argument, this and that are reached by stepping A from the
+ * segment base or, right after a pop to the same segment, from the
+ * address that pop left in A, instead of adding the index through D.
  * 
  * @param outputFile File pointer to the assembly output file
  * @param commandType The command type (C_PUSH or C_POP)
@@ -394,53 +551,33 @@ void writeArithmetic(FILE * outputFile, const char * command) {
  * @param index The index within the segment
  */
 void writePushPop(FILE * outputFile, int commandType, const char * segment, const char * index) {
+    const char * base = segmentBase(segment);
     if (commandType == C_PUSH) {
         if (strcmp(segment, "constant") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "M=M+1\n");
-        } else if (strcmp(segment, "local") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@LCL\n");
-            fprintf(outputFile, "A=M+D\n");
-            fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "M=M+1\n");
-        } else if (strcmp(segment, "argument") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@ARG\n");
-            fprintf(outputFile, "A=M+D\n");
-            fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "M=M+1\n");
-        } else if (strcmp(segment, "this") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@THIS\n");
-            fprintf(outputFile, "A=M+D\n");
-            fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
+            int value = atoi(index);
+            if (value > MAX_SHORT_CONSTANT) {
+                value -= 0x10000;
+            }
+            if (value >= -1 && value <= 1) {
+                fprintf(outputFile, "@SP\n");
+                fprintf(outputFile, "A=M\n");
+                fprintf(outputFile, "M=%d\n", value);
+            } else {
+                if (value < 0 && value > MIN_CONSTANT) {
+                    fprintf(outputFile, "@%d\n", -value);
+                    fprintf(outputFile, "D=-A\n");
+                } else {
+                    fprintf(outputFile, "@%d\n", value);
+                    fprintf(outputFile, "D=A\n");
+                }
+                fprintf(outputFile, "@SP\n");
+                fprintf(outputFile, "A=M\n");
+                fprintf(outputFile, "M=D\n");
+            }
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "M=M+1\n");
-        } else if (strcmp(segment, "that") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@THAT\n");
-            fprintf(outputFile, "A=M+D\n");
+        } else if (base != NULL) {
+            writeSegmentAddress(outputFile, base, atoi(index), true);
             fprintf(outputFile, "D=M\n");
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "A=M\n");
@@ -448,7 +585,7 @@ void writePushPop(FILE * outputFile, int commandType, const char * segment, cons
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "M=M+1\n");
         } else if (strcmp(segment, "static") == 0) {
-            fprintf(outputFile, "@%s.%s\n", curr, index);
+            fprintf(outputFile, "@%s\n", staticName(index));
             fprintf(outputFile, "D=M\n");
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "A=M\n");
@@ -456,10 +593,7 @@ void writePushPop(FILE * outputFile, int commandType, const char * segment, cons
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "M=M+1\n");
         } else if (strcmp(segment, "temp") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@5\n");
-            fprintf(outputFile, "A=A+D\n");
+            fprintf(outputFile, "@%d\n", TEMP_BASE + atoi(index));
             fprintf(outputFile, "D=M\n");
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "A=M\n");
@@ -481,24 +615,21 @@ void writePushPop(FILE * outputFile, int commandType, const char * segment, cons
         } else {
             fprintf(stderr, "Error: Invalid segment for push\n");
         }
+        knownBase = NULL;
     } else if (commandType == C_POP) {
-        if (strcmp(segment, "local") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@LCL\n");
-            fprintf(outputFile, "D=M+D\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "M=D\n");
+        if (base != NULL && atoi(index) <= MAX_POP_STEPS) {
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "AM=M-1\n");
             fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "A=M\n");
+            knownBase = NULL;
+            writeSegmentAddress(outputFile, base, atoi(index), false);
             fprintf(outputFile, "M=D\n");
-        } else if (strcmp(segment, "argument") == 0) {
+            knownBase = base;
+            knownIndex = atoi(index);
+        } else if (base != NULL) {
             fprintf(outputFile, "@%s\n", index);
             fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@ARG\n");
+            fprintf(outputFile, "@%s\n", base);
             fprintf(outputFile, "D=M+D\n");
             fprintf(outputFile, "@R13\n");
             fprintf(outputFile, "M=D\n");
@@ -508,51 +639,22 @@ void writePushPop(FILE * outputFile, int commandType, const char * segment, cons
             fprintf(outputFile, "@R13\n");
             fprintf(outputFile, "A=M\n");
             fprintf(outputFile, "M=D\n");
-        } else if (strcmp(segment, "this") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@THIS\n");
-            fprintf(outputFile, "D=M+D\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "M=D\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "AM=M-1\n");
-            fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
-        } else if (strcmp(segment, "that") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@THAT\n");
-            fprintf(outputFile, "D=M+D\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "M=D\n");
-            fprintf(outputFile, "@SP\n");
-            fprintf(outputFile, "AM=M-1\n"); 
-            fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "A=M\n");
-            fprintf(outputFile, "M=D\n");
+            knownBase = base;
+            knownIndex = atoi(index);
         } else if (strcmp(segment, "static") == 0) {
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "AM=M-1\n");
             fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@%s.%s\n", curr, index);
+            fprintf(outputFile, "@%s\n", staticName(index));
             fprintf(outputFile, "M=D\n");
+            knownBase = NULL;
         } else if (strcmp(segment, "temp") == 0) {
-            fprintf(outputFile, "@%s\n", index);
-            fprintf(outputFile, "D=A\n");
-            fprintf(outputFile, "@5\n");
-            fprintf(outputFile, "D=A+D\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "M=D\n");
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "AM=M-1\n");
             fprintf(outputFile, "D=M\n");
-            fprintf(outputFile, "@R13\n");
-            fprintf(outputFile, "A=M\n");
+            fprintf(outputFile, "@%d\n", TEMP_BASE + atoi(index));
             fprintf(outputFile, "M=D\n");
+            knownBase = NULL;
         } else if (strcmp(segment, "pointer") == 0) {
             fprintf(outputFile, "@SP\n");
             fprintf(outputFile, "AM=M-1\n");
@@ -563,6 +665,7 @@ void writePushPop(FILE * outputFile, int commandType, const char * segment, cons
                 fprintf(outputFile, "@THAT\n");
             }
             fprintf(outputFile, "M=D\n");
+            knownBase = NULL;
         } else {
             fprintf(stderr, "Error: Invalid segment for pop\n");
         }
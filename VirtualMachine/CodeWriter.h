@@ -12,6 +12,11 @@
 #define CODEWRITER_H
 
 #include "Config.h"
+#include "LabelMap.h"
+#include "../Assembler/MemoryMap.h"
+
+// Label of the return routine shared by all functions
+#define RETURN_ROUTINE  "$RETURN"
 
 /**
  * @brief Sets the current VM file name for static variable naming
@@ -27,12 +32,20 @@ void setFile(const char * fileName);
  */
 void setFunction(const char * functionName);
 
+/**
+ * @brief Switches generated symbols to the short names of a label map
+ * 
+ * @param map The label map assigning short names, or NULL for full names
+ */
+void setLabelMap(LabelMap * map);
+
 /**
  * @brief Writes VM initialization code to assembly output
  * 
  * @param outputFile File pointer to the assembly output file
+ * @param memoryMap Layout providing the stack base and the heap bounds
  */
-void writeInit(FILE * outputFile);
+void writeInit(FILE * outputFile, const MemoryMap * memoryMap);
 
 /**
  * @brief Writes label definition to assembly output
@@ -74,6 +87,14 @@ void writeCall(FILE * outputFile, const char * functionName, int numArgs);
  */
 void writeReturn(FILE * outputFile);
 
+/**
+ * @brief Writes the code shared by the translated files
+ * 
+ * @param outputFile File pointer to the assembly output file
+ * @return The number of labels defined
+ */
+int writeEnd(FILE * outputFile);
+
 /**
  * @brief Writes function definition to assembly output
  * 
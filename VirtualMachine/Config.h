@@ -10,8 +10,12 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Expose strdup under -std=c99; without a prototype its result is truncated to int
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
 #include <dirent.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -24,7 +28,15 @@
 #define MAX_PATH_LENGTH         256
 #define MAX_FILENAME_LENGTH     256
 #define MAX_ARG_LENGTH          256
-#define MAX_RETURN_COUNTER      256
+
+// Constant Range: values above MAX_SHORT_CONSTANT are 16-bit two's complement
+#define MIN_CONSTANT            -32768
+#define MAX_SHORT_CONSTANT      32767
+#define MAX_CONSTANT            65535
+
+// Segment Addressing
+#define TEMP_BASE               5   // RAM address of temp 0
+#define MAX_POP_STEPS           6   // Highest pop index reached by stepping A from the base
 
 // Command Types
 #define C_ARITHMETIC    0
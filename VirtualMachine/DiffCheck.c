@@ -0,0 +1,463 @@
+/**
+ * @file DiffCheck.c
+ * @brief Differential checker for the VM translator and assembler
+ *
+ * This file contains the entry point of DiffCheck, which runs a program two
+ * ways in lockstep: the .vm files on the reference interpreter (see
+ * Interpreter.h), and the translated and assembled .hack file on the
+ * emulator's CPU. Every time a function returns, the function name, the
+ * return value, all static variables (matched through the translator's
+ * static names in the assembler's .sym file) and every heap or screen word
+ * written since the previous return are compared. The first divergence is
+ * reported together with the function that was returning. Both sides use
+ * the memory map recorded in the .sym file.
+ */
+
+#include "Config.h"
+#include "Interpreter.h"
+#include "../Emulator/CPU.h"
+#include "../Emulator/Loader.h"
+
+// Step Results
+#define STEP_RETURN     0
+#define STEP_HALT       1
+#define STEP_LIMIT      2
+
+/**
+ * @brief An activation of a VM function on the Hack side
+ */
+typedef struct HackFrame {
+    int function;               // VM function id
+    uint16_t returnAddress;
+    uint16_t lcl;
+    uint16_t arg;
+} HackFrame;
+
+/**
+ * @brief State of the Hack side of the comparison
+ */
+typedef struct HackSide {
+    CPU cpu;
+    Symbols symbols;
+    int * entryFunction;        // VM function id for each ROM address, or -1
+    int * staticAddress;        // RAM address of each VM static, or -1
+    HackFrame * frames;
+    size_t depth;
+    size_t capacity;
+    uint8_t * dirty;
+    uint16_t * dirtyList;
+    size_t dirtyCount;
+    int haltFunction;
+    uint16_t returnValue;
+} HackSide;
+
+/**
+ * @brief Command line options
+ */
+typedef struct Options {
+    const char * vmName;
+    const char * programName;
+    const char * symbolName;
+    uint64_t cycleLimit;
+} Options;
+
+/**
+ * @brief Prints command line usage
+ */
+static void printUsage(void) {
+    fprintf(stderr,
+            "Usage: DiffCheck [OPTIONS] PATH\n"
+            "  PATH                 Directory of .vm files, or a single .vm file\n"
+            "  --hack FILE          Assembled program (default: DIR/DIR.hack or FILE.hack)\n"
+            "  --symbols FILE       Symbol file written by Assembler -s (default: the .hack name with .sym)\n"
+            "  --cycles N           Stop after N Hack instructions (default: no limit)\n");
+}
+
+/**
+ * @brief Parses command line arguments
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param options Pointer to the options to fill
+ * @return true on success, false if usage should be printed
+ */
+static bool parseArguments(int argc, char * argv[], Options * options) {
+    memset(options, 0, sizeof(Options));
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--hack") == 0 && hasValue) {
+            options->programName = argv[++i];
+        } else if (strcmp(argv[i], "--symbols") == 0 && hasValue) {
+            options->symbolName = argv[++i];
+        } else if (strcmp(argv[i], "--cycles") == 0 && hasValue) {
+            options->cycleLimit = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-' || options->vmName != NULL) {
+            return false;
+        } else {
+            options->vmName = argv[i];
+        }
+    }
+    return options->vmName != NULL;
+}
+
+/**
+ * @brief Derives the default .hack path from the VM path
+ *
+ * Mirrors the toolchain: a directory DIR yields DIR/DIR.hack, a file
+ * FILE.vm yields FILE.hack.
+ *
+ * @param vmName Directory or .vm file
+ * @param buffer Buffer receiving the path
+ * @param bufferSize Size of the buffer
+ */
+static void defaultProgramName(const char * vmName, char * buffer, size_t bufferSize) {
+    struct stat pathStat;
+    if (stat(vmName, &pathStat) == 0 && S_ISDIR(pathStat.st_mode)) {
+        size_t length = strlen(vmName);
+        while (length > 1 && vmName[length - 1] == '/') {
+            length--;
+        }
+        const char * base = vmName + length;
+        while (base > vmName && base[-1] != '/') {
+            base--;
+        }
+        snprintf(buffer, bufferSize, "%.*s/%.*s.hack", (int) length, vmName, (int) (vmName + length - base), base);
+    } else {
+        const char * extension = strrchr(vmName, '.');
+        int length = extension ? (int) (extension - vmName) : (int) strlen(vmName);
+        snprintf(buffer, bufferSize, "%.*s.hack", length, vmName);
+    }
+}
+
+/**
+ * @brief Loads the ROM and maps it and the loaded symbols onto the VM program
+ *
+ * @param hack Pointer to the Hack side, whose symbols are already loaded
+ * @param program Pointer to the loaded VM program
+ * @param programName Path of the .hack file
+ * @param symbolName Path of the .sym file
+ * @return true on success, false on I/O or allocation errors
+ */
+static bool initHackSide(HackSide * hack, const VMProgram * program, const char * programName, const char * symbolName) {
+    if (!initCPU(&hack->cpu) || !loadProgram(&hack->cpu, programName)) {
+        return false;
+    }
+
+    hack->entryFunction = malloc(ROM_SIZE * sizeof(int));
+    hack->staticAddress = malloc((program->staticCount + 1) * sizeof(int));
+    hack->dirty = calloc(RAM_SIZE, sizeof(uint8_t));
+    hack->dirtyList = malloc(RAM_SIZE * sizeof(uint16_t));
+    if (hack->entryFunction == NULL || hack->staticAddress == NULL || hack->dirty == NULL || hack->dirtyList == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ROM_SIZE; i++) {
+        hack->entryFunction[i] = -1;
+    }
+    for (size_t i = 0; i < program->functionCount; i++) {
+        int address = findSymbol(&hack->symbols, program->functions[i]);
+        if (address < 0) {
+            fprintf(stderr, "Error: Function %s is missing from %s\n", program->functions[i], symbolName);
+            return false;
+        }
+        hack->entryFunction[address] = (int) i;
+    }
+    for (size_t i = 0; i < program->staticCount; i++) {
+        hack->staticAddress[i] = findSymbol(&hack->symbols, program->statics[i].name);
+    }
+
+    // Single-file programs have no bootstrap; start them with the interpreter's stack
+    if (!program->bootstrap) {
+        hack->cpu.ram[RAM_SP] = hack->symbols.layout.stackBase;
+    }
+
+    hack->haltFunction = findVMFunction(program, "Sys.halt");
+    return true;
+}
+
+/**
+ * @brief Frees all memory owned by the Hack side
+ *
+ * @param hack Pointer to the Hack side to clean up
+ */
+static void cleanupHackSide(HackSide * hack) {
+    cleanupCPU(&hack->cpu);
+    cleanupSymbols(&hack->symbols);
+    free(hack->entryFunction);
+    free(hack->staticAddress);
+    free(hack->frames);
+    free(hack->dirty);
+    free(hack->dirtyList);
+}
+
+/**
+ * @brief Runs the ROM until a VM function returns or the program halts
+ *
+ * Function entries are recognized by the PC reaching a function label right
+ * after a jump with LCL == SP, and returns by the PC reaching the recorded
+ * return address with SP == ARG + 1. A loop back to a function's first
+ * label is told apart from a recursive call by its unchanged LCL.
+ *
+ * @param hack Pointer to the Hack side
+ * @param limit Cycle count at which to stop (0 for no limit)
+ * @param function Receives the id of the returning function
+ * @return STEP_RETURN, STEP_HALT or STEP_LIMIT
+ */
+static int runHack(HackSide * hack, uint64_t limit, int * function) {
+    CPU * cpu = &hack->cpu;
+    uint16_t * ram = cpu->ram;
+    uint16_t heapBase = hack->symbols.layout.heapBase;
+    uint16_t heapLimit = hack->symbols.layout.heapLimit;
+
+    while (limit == 0 || cpu->cycles < limit) {
+        uint16_t pc = cpu->pc;
+        uint16_t instruction = cpu->rom[pc];
+        if ((instruction & 0x8008) == 0x8008) {
+            uint16_t address = cpu->a & RAM_MASK;
+            if (address >= heapBase && (address <= heapLimit || address >= RAM_SCREEN) && !hack->dirty[address]) {
+                hack->dirty[address] = 1;
+                hack->dirtyList[hack->dirtyCount++] = address;
+            }
+        }
+
+        if (cpuStep(cpu)) {
+            return STEP_HALT;
+        }
+        if (cpu->pc == (uint16_t) (pc + 1)) {
+            continue;
+        }
+
+        if (hack->depth > 0) {
+            const HackFrame * top = &hack->frames[hack->depth - 1];
+            if (cpu->pc == top->returnAddress && ram[RAM_SP] == (uint16_t) (top->arg + 1)) {
+                *function = top->function;
+                hack->returnValue = ram[top->arg & RAM_MASK];
+                hack->depth--;
+                return STEP_RETURN;
+            }
+        }
+
+        int entry = hack->entryFunction[cpu->pc];
+        if (entry < 0 || ram[RAM_LCL] != ram[RAM_SP]) {
+            continue;
+        }
+        if (hack->depth > 0) {
+            const HackFrame * top = &hack->frames[hack->depth - 1];
+            if (top->function == entry && top->lcl == ram[RAM_LCL]) {
+                continue;
+            }
+        }
+        if (entry == hack->haltFunction) {
+            return STEP_HALT;
+        }
+
+        if (hack->depth == hack->capacity) {
+            size_t capacity = hack->capacity ? hack->capacity * 2 : 256;
+            HackFrame * frames = realloc(hack->frames, capacity * sizeof(HackFrame));
+            if (frames == NULL) {
+                fprintf(stderr, "Error: Out of memory\n");
+                return STEP_LIMIT;
+            }
+            hack->frames = frames;
+            hack->capacity = capacity;
+        }
+
+        HackFrame * frame = &hack->frames[hack->depth++];
+        frame->function = entry;
+        frame->lcl = ram[RAM_LCL];
+        frame->arg = ram[RAM_ARG];
+        frame->returnAddress = ram[(uint16_t) (ram[RAM_LCL] - 5) & RAM_MASK];
+    }
+    return STEP_LIMIT;
+}
+
+/**
+ * @brief Compares one RAM word of both sides and reports a mismatch
+ *
+ * @param what Description of the word
+ * @param vmValue Value on the interpreter
+ * @param hackValue Value on the ROM
+ * @param context Name of the returning function
+ * @param returns Number of returns compared so far
+ * @return true if the values match
+ */
+static bool compareWord(const char * what, uint16_t vmValue, uint16_t hackValue, const char * context, uint64_t returns) {
+    if (vmValue == hackValue) {
+        return true;
+    }
+
+    printf("Divergence at return %llu from %s: %s is %d on the VM but %d on the ROM\n",
+           (unsigned long long) returns, context, what, (int16_t) vmValue, (int16_t) hackValue);
+    return false;
+}
+
+/**
+ * @brief Compares statics and every heap or screen word written by either side
+ *
+ * @param vm Pointer to the interpreter
+ * @param hack Pointer to the Hack side
+ * @param context Name of the returning function
+ * @param returns Number of returns compared so far
+ * @return true if both sides agree
+ */
+static bool compareMemory(VMMachine * vm, HackSide * hack, const char * context, uint64_t returns) {
+    const VMProgram * program = vm->program;
+    const uint16_t * hackRam = hack->cpu.ram;
+    char what[MAX_ARG_LENGTH + 16];
+
+    for (size_t i = 0; i < program->staticCount; i++) {
+        if (hack->staticAddress[i] < 0) {
+            continue;
+        }
+        snprintf(what, sizeof(what), "static %s", program->statics[i].name);
+        if (!compareWord(what, vm->ram[program->statics[i].address], hackRam[hack->staticAddress[i]], context, returns)) {
+            return false;
+        }
+    }
+
+    bool match = true;
+    for (size_t side = 0; side < 2 && match; side++) {
+        const uint16_t * list = side == 0 ? vm->dirtyList : hack->dirtyList;
+        size_t count = side == 0 ? vm->dirtyCount : hack->dirtyCount;
+        for (size_t i = 0; i < count && match; i++) {
+            uint16_t address = list[i];
+            snprintf(what, sizeof(what), "RAM[%u]", address);
+            match = compareWord(what, vm->ram[address], hackRam[address], context, returns);
+        }
+    }
+
+    clearDirty(vm);
+    for (size_t i = 0; i < hack->dirtyCount; i++) {
+        hack->dirty[hack->dirtyList[i]] = 0;
+    }
+    hack->dirtyCount = 0;
+    return match;
+}
+
+/**
+ * @brief Runs both sides in lockstep, one function return at a time
+ *
+ * @param vm Pointer to the interpreter
+ * @param hack Pointer to the Hack side
+ * @param cycleLimit Hack cycle budget (0 for no limit)
+ * @return 0 if no divergence was found, 1 otherwise
+ */
+static int check(VMMachine * vm, HackSide * hack, uint64_t cycleLimit) {
+    const VMProgram * program = vm->program;
+    uint64_t returns = 0;
+
+    for (;;) {
+        int hackFunction = -1;
+        int hackResult = runHack(hack, cycleLimit, &hackFunction);
+        if (hackResult == STEP_LIMIT) {
+            printf("Cycle limit reached after %llu returns without divergence\n", (unsigned long long) returns);
+            return 0;
+        }
+
+        int vmFunction = -1;
+        int vmResult = runVM(vm, cycleLimit ? cycleLimit * 2 : 0, &vmFunction);
+        if (vmResult == VM_ERROR) {
+            return 1;
+        }
+        if (vmResult == VM_LIMIT) {
+            printf("Divergence at return %llu: the VM did not reach the next return within the cycle budget\n",
+                   (unsigned long long) returns + 1);
+            return 1;
+        }
+
+        const char * vmName = vmFunction >= 0 ? program->functions[vmFunction] : "(top level)";
+        const char * hackName = hackFunction >= 0 ? program->functions[hackFunction] : "(top level)";
+
+        if (vmResult == VM_HALT || hackResult == STEP_HALT) {
+            if (vmResult != VM_HALT) {
+                printf("Divergence at return %llu: the ROM halted but the VM returned from %s\n",
+                       (unsigned long long) returns + 1, vmName);
+                return 1;
+            }
+            if (hackResult != STEP_HALT) {
+                printf("Divergence at return %llu: the VM halted but the ROM returned from %s\n",
+                       (unsigned long long) returns + 1, hackName);
+                return 1;
+            }
+            if (!compareMemory(vm, hack, "the halted program", returns)) {
+                return 1;
+            }
+            printf("Both sides halted after %llu returns without divergence\n", (unsigned long long) returns);
+            return 0;
+        }
+
+        returns++;
+        if (vmFunction != hackFunction) {
+            printf("Divergence at return %llu: the VM returned from %s but the ROM from %s\n",
+                   (unsigned long long) returns, vmName, hackName);
+            return 1;
+        }
+
+        uint16_t vmValue = vm->ram[(uint16_t) (vm->ram[0] - 1) & (VM_RAM_SIZE - 1)];
+        if (!compareWord("the return value", vmValue, hack->returnValue, vmName, returns) ||
+            !compareMemory(vm, hack, vmName, returns)) {
+            return 1;
+        }
+    }
+}
+
+/**
+ * @brief Main entry point for the differential checker
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return 0 if no divergence was found, 1 on divergence or error
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    char programName[MAX_PATH_LENGTH];
+    char symbolName[MAX_PATH_LENGTH];
+    if (options.programName == NULL) {
+        defaultProgramName(options.vmName, programName, sizeof(programName));
+        options.programName = programName;
+    }
+    if (options.symbolName == NULL) {
+        const char * extension = strrchr(options.programName, '.');
+        int length = extension ? (int) (extension - options.programName) : (int) strlen(options.programName);
+        snprintf(symbolName, sizeof(symbolName), "%.*s.sym", length, options.programName);
+        options.symbolName = symbolName;
+    }
+
+    int result = 1;
+    VMProgram program;
+    VMMachine vm;
+    HackSide hack;
+    memset(&vm, 0, sizeof(vm));
+    memset(&hack, 0, sizeof(hack));
+
+    // The symbol file records the memory map, which the interpreter needs before loading
+    if (!loadSymbols(&hack.symbols, options.symbolName)) {
+        fprintf(stderr, "Error: Failed to load %s\n", options.symbolName);
+        return 1;
+    }
+    if (!loadVMProgram(&program, options.vmName, &hack.symbols.layout)) {
+        cleanupSymbols(&hack.symbols);
+        return 1;
+    }
+    if (!initVM(&vm, &program)) {
+        goto cleanup;
+    }
+    if (!initHackSide(&hack, &program, options.programName, options.symbolName)) {
+        fprintf(stderr, "Error: Failed to load %s\n", options.programName);
+        goto cleanup;
+    }
+
+    result = check(&vm, &hack, options.cycleLimit);
+
+cleanup:
+    cleanupHackSide(&hack);
+    cleanupVM(&vm);
+    cleanupVMProgram(&program);
+    return result;
+}
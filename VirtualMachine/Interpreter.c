@@ -0,0 +1,748 @@
+/**
+ * @file Interpreter.c
+ * @brief Reference interpreter for Hack Virtual Machine programs
+ *
+ * This file loads .vm files into an array of decoded commands and executes
+ * them directly. Labels and calls are resolved to command indices once at
+ * load time. The memory layout and calling convention (the five-word frame
+ * pushed by call) follow the standard VM mapping so programs that inspect
+ * their own memory behave the same here as on the translated ROM.
+ */
+
+#include "Interpreter.h"
+#include "../Assembler/LineScanner.h"
+#include "Parser.h"
+#include "Statistics.h"
+
+#define SP      vm->ram[0]
+#define LCL     vm->ram[1]
+#define ARG     vm->ram[2]
+#define THIS    vm->ram[3]
+#define THAT    vm->ram[4]
+
+/**
+ * @brief A label or call target waiting to be resolved after loading
+ */
+typedef struct Reference {
+    char * name;
+    size_t command;
+} Reference;
+
+/**
+ * @brief Temporary state used while loading a program
+ */
+typedef struct Loader {
+    char ** labels;             // Scoped label names ("function$label")
+    size_t * labelTargets;
+    size_t labelCount;
+    size_t labelCapacity;
+    Reference * references;     // goto, if-goto and call operands
+    size_t referenceCount;
+    size_t referenceCapacity;
+    int function;               // Function currently being loaded, or -1
+} Loader;
+
+/**
+ * @brief Grows a dynamic array so that one more element fits
+ *
+ * @param array Pointer to the array pointer
+ * @param capacity Pointer to the current capacity
+ * @param count The number of elements in use
+ * @param size The size of one element
+ * @return true on success, false if allocation failed
+ */
+static bool reserve(void ** array, size_t * capacity, size_t count, size_t size) {
+    if (count < *capacity) {
+        return true;
+    }
+
+    size_t newCapacity = *capacity ? *capacity * 2 : 64;
+    void * grown = realloc(*array, newCapacity * size);
+    if (grown == NULL) {
+        return false;
+    }
+
+    *array = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+/**
+ * @brief Decodes an arithmetic command name
+ *
+ * @param name The command name
+ * @return The OP_ constant, or -1 if unknown
+ */
+static int decodeOperation(const char * name) {
+    static const char * const names[] = {"add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not"};
+    for (int i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Decodes a memory segment name
+ *
+ * @param name The segment name
+ * @return The SEG_ constant, or -1 if unknown
+ */
+static int decodeSegment(const char * name) {
+    static const char * const names[] = {"constant", "local", "argument", "this", "that", "pointer", "temp", "static"};
+    for (int i = 0; i < (int) (sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Returns the slot of a static variable, allocating it on first use
+ *
+ * @param program Pointer to the program being loaded
+ * @param name The translator's name for the static
+ * @return The slot, or -1 on allocation errors or when statics run out
+ */
+static int internStatic(VMProgram * program, const char * name) {
+    for (size_t i = 0; i < program->staticCount; i++) {
+        if (strcmp(program->statics[i].name, name) == 0) {
+            return (int) i;
+        }
+    }
+
+    if (program->layout.staticBase + program->staticCount > program->layout.staticLimit) {
+        fprintf(stderr, "Error: Too many static variables\n");
+        return -1;
+    }
+    if (!reserve((void **) &program->statics, &program->staticCapacity, program->staticCount, sizeof(VMStatic))) {
+        return -1;
+    }
+
+    char * copy = strdup(name);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    program->statics[program->staticCount].name = copy;
+    program->statics[program->staticCount].address = (uint16_t) (program->layout.staticBase + program->staticCount);
+    return (int) program->staticCount++;
+}
+
+/**
+ * @brief Records a label or call target name for resolution after loading
+ *
+ * @param loader Pointer to the loader state
+ * @param label true to define a label, false to record a use
+ * @param name The (already scoped) name
+ * @param command The command index defining or using the name
+ * @return true on success, false if allocation failed
+ */
+static bool addReference(Loader * loader, bool label, const char * name, size_t command) {
+    char * copy = strdup(name);
+    if (copy == NULL) {
+        return false;
+    }
+
+    if (label) {
+        if (!reserve((void **) &loader->labels, &loader->labelCapacity, loader->labelCount, sizeof(char *))) {
+            free(copy);
+            return false;
+        }
+        size_t capacity = loader->labelCapacity;
+        size_t * targets = realloc(loader->labelTargets, capacity * sizeof(size_t));
+        if (targets == NULL) {
+            free(copy);
+            return false;
+        }
+        loader->labelTargets = targets;
+        loader->labels[loader->labelCount] = copy;
+        loader->labelTargets[loader->labelCount++] = command;
+    } else {
+        if (!reserve((void **) &loader->references, &loader->referenceCapacity, loader->referenceCount, sizeof(Reference))) {
+            free(copy);
+            return false;
+        }
+        loader->references[loader->referenceCount].name = copy;
+        loader->references[loader->referenceCount++].command = command;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the scoped name of a label the way the translator does
+ *
+ * @param program Pointer to the program being loaded
+ * @param loader Pointer to the loader state
+ * @param label The label as written in the VM file
+ * @param buffer Buffer receiving the scoped name
+ * @param bufferSize Size of the buffer
+ */
+static void scopeLabel(const VMProgram * program, const Loader * loader, const char * label, char * buffer, size_t bufferSize) {
+    if (loader->function >= 0) {
+        snprintf(buffer, bufferSize, "%s$%s", program->functions[loader->function], label);
+    } else {
+        snprintf(buffer, bufferSize, "%s", label);
+    }
+}
+
+/**
+ * @brief Parses one .vm file and appends its commands to the program
+ *
+ * @param program Pointer to the program being loaded
+ * @param loader Pointer to the loader state
+ * @param path Path of the .vm file
+ * @param staticPrefix File name used to build static names
+ * @return true on success, false on I/O or parse errors
+ */
+static bool loadFile(VMProgram * program, Loader * loader, const char * path, const char * staticPrefix) {
+    size_t size;
+    char * text = readSourceFile(path, &size);
+    LineIndex lines = {0};
+    if (text == NULL || !buildLineIndex(&lines, text, size)) {
+        fprintf(stderr, "Error: Failed to read input file %s\n", path);
+        free(text);
+        freeLineIndex(&lines);
+        return false;
+    }
+
+    char currLine[MAX_LINE_LENGTH];
+    char arg1[MAX_ARG_LENGTH];
+    char arg2[MAX_ARG_LENGTH];
+    char name[MAX_PATH_LENGTH + MAX_ARG_LENGTH + 2];
+
+    for (size_t i = 0; i < lines.count; i++) {
+        int lineNumber = (int) lines.lines[i].number;
+        char * trimmed = currLine;
+        if (!copySourceLine(text, &lines.lines[i], currLine, sizeof(currLine))) {
+            fprintf(stderr, "Error: Line too long in %s:%d\n", path, lineNumber);
+            free(text);
+            freeLineIndex(&lines);
+            return false;
+        }
+
+        int commandType = getCommandType(trimmed);
+        if (commandType == C_UNKNOWN) {
+            fprintf(stderr, "Error: Unknown command in %s:%d\n", path, lineNumber);
+            free(text);
+            freeLineIndex(&lines);
+            return false;
+        }
+
+        if (!reserve((void **) &program->commands, &program->commandCapacity, program->commandCount, sizeof(VMCommand))) {
+            free(text);
+            freeLineIndex(&lines);
+            return false;
+        }
+
+        size_t position = program->commandCount;
+        VMCommand * command = &program->commands[position];
+        memset(command, 0, sizeof(*command));
+        command->type = commandType;
+
+        bool valid = true;
+        if (commandType != C_RETURN) {
+            valid = getArg1(trimmed, commandType, arg1, sizeof(arg1)) != NULL;
+        }
+        if (valid && (commandType == C_PUSH || commandType == C_POP || commandType == C_FUNCTION || commandType == C_CALL)) {
+            valid = getArg2(trimmed, arg2, sizeof(arg2)) != NULL;
+            if (valid) {
+                command->index = atoi(arg2);
+            }
+        }
+
+        if (valid) {
+            switch (commandType) {
+                case C_ARITHMETIC:
+                    command->operation = decodeOperation(arg1);
+                    valid = command->operation >= 0;
+                    break;
+                case C_PUSH:
+                case C_POP:
+                    command->operation = decodeSegment(arg1);
+                    valid = command->operation >= 0
+                        && (command->operation == SEG_CONSTANT
+                            ? command->index >= MIN_CONSTANT && command->index <= MAX_CONSTANT
+                            : command->index >= 0)
+                        && !(commandType == C_POP && command->operation == SEG_CONSTANT)
+                        && !(command->operation == SEG_POINTER && command->index > 1)
+                        && !(command->operation == SEG_TEMP && command->index > 7);
+                    if (valid && command->operation == SEG_STATIC) {
+                        snprintf(name, sizeof(name), "%s.%d", staticPrefix, command->index);
+                        command->index = internStatic(program, name);
+                        valid = command->index >= 0;
+                    }
+                    break;
+                case C_LABEL:
+                    scopeLabel(program, loader, arg1, name, sizeof(name));
+                    valid = addReference(loader, true, name, position);
+                    break;
+                case C_GOTO:
+                case C_IF:
+                    scopeLabel(program, loader, arg1, name, sizeof(name));
+                    valid = addReference(loader, false, name, position);
+                    break;
+                case C_CALL:
+                    valid = command->index >= 0 && addReference(loader, false, arg1, position);
+                    break;
+                case C_FUNCTION: {
+                    if (findVMFunction(program, arg1) >= 0) {
+                        fprintf(stderr, "Error: Function %s defined twice\n", arg1);
+                        valid = false;
+                        break;
+                    }
+                    if (!reserve((void **) &program->functions, &program->functionCapacity, program->functionCount, sizeof(char *))) {
+                        valid = false;
+                        break;
+                    }
+                    int * starts = realloc(program->functionStart, program->functionCapacity * sizeof(int));
+                    char * copy = strdup(arg1);
+                    if (starts == NULL || copy == NULL) {
+                        if (starts != NULL) {
+                            program->functionStart = starts;
+                        }
+                        free(copy);
+                        valid = false;
+                        break;
+                    }
+                    program->functionStart = starts;
+                    program->functions[program->functionCount] = copy;
+                    program->functionStart[program->functionCount] = (int) position;
+                    loader->function = (int) program->functionCount++;
+                    valid = command->index >= 0;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        if (!valid) {
+            fprintf(stderr, "Error: Invalid command in %s:%d\n", path, lineNumber);
+            free(text);
+            freeLineIndex(&lines);
+            return false;
+        }
+
+        command->function = loader->function;
+        program->commandCount++;
+    }
+
+    free(text);
+    freeLineIndex(&lines);
+    return true;
+}
+
+/**
+ * @brief Resolves goto, if-goto and call operands to command indices
+ *
+ * @param program Pointer to the loaded program
+ * @param loader Pointer to the loader state
+ * @return true on success, false if a label or function is undefined
+ */
+static bool resolveReferences(VMProgram * program, const Loader * loader) {
+    for (size_t i = 0; i < loader->referenceCount; i++) {
+        const Reference * reference = &loader->references[i];
+        VMCommand * command = &program->commands[reference->command];
+        command->target = -1;
+
+        if (command->type == C_CALL) {
+            int function = findVMFunction(program, reference->name);
+            if (function >= 0) {
+                command->target = program->functionStart[function];
+            }
+        } else {
+            for (size_t j = 0; j < loader->labelCount; j++) {
+                if (strcmp(loader->labels[j], reference->name) == 0) {
+                    command->target = (int) loader->labelTargets[j];
+                    break;
+                }
+            }
+        }
+
+        if (command->target < 0) {
+            fprintf(stderr, "Error: Undefined %s %s\n", command->type == C_CALL ? "function" : "label", reference->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Frees the loader's temporary tables
+ *
+ * @param loader Pointer to the loader state
+ */
+static void cleanupLoader(Loader * loader) {
+    for (size_t i = 0; i < loader->labelCount; i++) {
+        free(loader->labels[i]);
+    }
+    for (size_t i = 0; i < loader->referenceCount; i++) {
+        free(loader->references[i].name);
+    }
+    free(loader->labels);
+    free(loader->labelTargets);
+    free(loader->references);
+}
+
+/**
+ * @brief Loads every .vm file of a directory, or a single .vm file
+ *
+ * Static names follow the translator: the file name including ".vm" in
+ * directory mode, the path without ".vm" in single-file mode.
+ *
+ * @param program Pointer to the program to fill
+ * @param path Directory or .vm file
+ * @param layout Memory map the program runs with
+ * @return true on success, false on I/O or parse errors
+ */
+bool loadVMProgram(VMProgram * program, const char * path, const MemoryMap * layout) {
+    memset(program, 0, sizeof(*program));
+    program->layout = *layout;
+    Loader loader;
+    memset(&loader, 0, sizeof(loader));
+    loader.function = -1;
+
+    struct stat pathStat;
+    if (stat(path, &pathStat) != 0) {
+        fprintf(stderr, "Error: Failed to open %s\n", path);
+        return false;
+    }
+
+    bool success = true;
+    if (S_ISDIR(pathStat.st_mode)) {
+        DIR * dir = opendir(path);
+        if (dir == NULL) {
+            fprintf(stderr, "Error: Failed to open directory\n");
+            return false;
+        }
+
+        struct dirent * entry;
+        while (success && (entry = readdir(dir)) != NULL) {
+            char * extension = strrchr(entry->d_name, '.');
+            if (extension == NULL || strcmp(extension, ".vm") != 0) {
+                continue;
+            }
+
+            char fullPath[MAX_PATH_LENGTH + MAX_FILENAME_LENGTH + 1];
+            snprintf(fullPath, sizeof(fullPath), "%s/%s", path, entry->d_name);
+            loader.function = -1;
+            success = loadFile(program, &loader, fullPath, entry->d_name);
+        }
+        closedir(dir);
+        program->bootstrap = true;
+    } else {
+        const char * extension = strrchr(path, '.');
+        if (extension == NULL || strcmp(extension, ".vm") != 0) {
+            fprintf(stderr, "Error: Invalid file type\n");
+            return false;
+        }
+
+        char prefix[MAX_PATH_LENGTH];
+        snprintf(prefix, sizeof(prefix), "%.*s", (int) (extension - path), path);
+        success = loadFile(program, &loader, path, prefix);
+    }
+
+    success = success && resolveReferences(program, &loader);
+    cleanupLoader(&loader);
+    if (!success) {
+        cleanupVMProgram(program);
+    }
+    return success;
+}
+
+/**
+ * @brief Looks up a function id by name
+ *
+ * @param program Pointer to the program
+ * @param name Fully qualified function name
+ * @return The function id, or -1 if the function is not defined
+ */
+int findVMFunction(const VMProgram * program, const char * name) {
+    for (size_t i = 0; i < program->functionCount; i++) {
+        if (strcmp(program->functions[i], name) == 0) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Frees all memory owned by a program
+ *
+ * @param program Pointer to the program to clean up
+ */
+void cleanupVMProgram(VMProgram * program) {
+    for (size_t i = 0; i < program->functionCount; i++) {
+        free(program->functions[i]);
+    }
+    for (size_t i = 0; i < program->staticCount; i++) {
+        free(program->statics[i].name);
+    }
+    free(program->commands);
+    free(program->functions);
+    free(program->functionStart);
+    free(program->statics);
+    memset(program, 0, sizeof(*program));
+}
+
+/**
+ * @brief Writes a RAM word, remembering heap and screen writes
+ *
+ * @param vm Pointer to the machine
+ * @param address The RAM address (wrapped to the RAM size)
+ * @param value The value to store
+ */
+static inline void writeRam(VMMachine * vm, uint16_t address, uint16_t value) {
+    address &= VM_RAM_SIZE - 1;
+    vm->ram[address] = value;
+    if (address >= vm->heapBase && (address <= vm->heapLimit || address >= VM_RAM_SCREEN) && !vm->dirty[address]) {
+        vm->dirty[address] = 1;
+        vm->dirtyList[vm->dirtyCount++] = address;
+    }
+}
+
+/**
+ * @brief Reads a RAM word
+ *
+ * @param vm Pointer to the machine
+ * @param address The RAM address (wrapped to the RAM size)
+ * @return The stored value
+ */
+static inline uint16_t readRam(const VMMachine * vm, uint16_t address) {
+    return vm->ram[address & (VM_RAM_SIZE - 1)];
+}
+
+/**
+ * @brief Pushes a value onto the stack
+ *
+ * @param vm Pointer to the machine
+ * @param value The value to push
+ */
+static inline void push(VMMachine * vm, uint16_t value) {
+    writeRam(vm, SP, value);
+    SP++;
+}
+
+/**
+ * @brief Pops a value from the stack
+ *
+ * @param vm Pointer to the machine
+ * @return The popped value
+ */
+static inline uint16_t pop(VMMachine * vm) {
+    SP--;
+    return readRam(vm, SP);
+}
+
+/**
+ * @brief Computes the RAM address of a segment entry
+ *
+ * @param vm Pointer to the machine
+ * @param segment The SEG_ constant (not SEG_CONSTANT)
+ * @param index The segment index (static slot for SEG_STATIC)
+ * @return The RAM address
+ */
+static inline uint16_t segmentAddress(const VMMachine * vm, int segment, int index) {
+    switch (segment) {
+        case SEG_LOCAL:     return (uint16_t) (LCL + index);
+        case SEG_ARGUMENT:  return (uint16_t) (ARG + index);
+        case SEG_THIS:      return (uint16_t) (THIS + index);
+        case SEG_THAT:      return (uint16_t) (THAT + index);
+        case SEG_POINTER:   return (uint16_t) (3 + index);
+        case SEG_TEMP:      return (uint16_t) (VM_RAM_TEMP + index);
+        default:            return vm->program->statics[index].address;
+    }
+}
+
+/**
+ * @brief Allocates memory and sets up the machine to run from Sys.init
+ *
+ * Directory programs get the translator's bootstrap for the program's
+ * memory map: the heap bounds pushed at the stack base followed by a call
+ * to Sys.init(heapBase, heapLimit) whose return address is the end of the
+ * program.
+ *
+ * @param vm Pointer to the machine to initialize
+ * @param program Pointer to the loaded program
+ * @return true on success, false on allocation errors or a missing entry point
+ */
+bool initVM(VMMachine * vm, const VMProgram * program) {
+    memset(vm, 0, sizeof(*vm));
+    vm->program = program;
+    vm->ram = calloc(VM_RAM_SIZE, sizeof(uint16_t));
+    vm->dirty = calloc(VM_RAM_SIZE, sizeof(uint8_t));
+    vm->dirtyList = malloc(VM_RAM_SIZE * sizeof(uint16_t));
+    if (vm->ram == NULL || vm->dirty == NULL || vm->dirtyList == NULL) {
+        cleanupVM(vm);
+        return false;
+    }
+
+    vm->haltFunction = findVMFunction(program, "Sys.halt");
+    vm->heapBase = program->layout.heapBase;
+    vm->heapLimit = program->layout.heapLimit;
+    SP = program->layout.stackBase;
+
+    if (program->bootstrap) {
+        int init = findVMFunction(program, "Sys.init");
+        if (init < 0) {
+            fprintf(stderr, "Error: Sys.init is not defined\n");
+            cleanupVM(vm);
+            return false;
+        }
+
+        push(vm, program->layout.heapBase);
+        push(vm, program->layout.heapLimit);
+        push(vm, (uint16_t) program->commandCount);
+        push(vm, LCL);
+        push(vm, ARG);
+        push(vm, THIS);
+        push(vm, THAT);
+        ARG = (uint16_t) (SP - 7);
+        LCL = SP;
+        vm->pc = (size_t) program->functionStart[init];
+    }
+    return true;
+}
+
+/**
+ * @brief Executes commands until a function returns or the program halts
+ *
+ * Comparisons test the sign of the 16-bit difference x - y, which is what
+ * the translated code computes, so both sides agree even when it overflows.
+ *
+ * @param vm Pointer to the machine
+ * @param limit Step count at which to stop (0 for no limit)
+ * @param function Receives the id of the returning function
+ * @return VM_RETURN, VM_HALT, VM_LIMIT or VM_ERROR
+ */
+int runVM(VMMachine * vm, uint64_t limit, int * function) {
+    const VMCommand * commands = vm->program->commands;
+    size_t count = vm->program->commandCount;
+
+    while (limit == 0 || vm->steps < limit) {
+        if (vm->pc >= count) {
+            return VM_HALT;
+        }
+
+        const VMCommand * command = &commands[vm->pc++];
+        vm->steps++;
+        if (vm->stats != NULL) {
+            recordStep(vm->stats, command);
+        }
+
+        switch (command->type) {
+            case C_ARITHMETIC: {
+                if (command->operation == OP_NEG || command->operation == OP_NOT) {
+                    uint16_t x = pop(vm);
+                    push(vm, command->operation == OP_NEG ? (uint16_t) -x : (uint16_t) ~x);
+                    break;
+                }
+
+                uint16_t y = pop(vm);
+                uint16_t x = pop(vm);
+                int16_t difference = (int16_t) (uint16_t) (x - y);
+                uint16_t result = 0;
+                switch (command->operation) {
+                    case OP_ADD: result = (uint16_t) (x + y); break;
+                    case OP_SUB: result = (uint16_t) (x - y); break;
+                    case OP_EQ:  result = difference == 0 ? 0xFFFF : 0; break;
+                    case OP_GT:  result = difference > 0 ? 0xFFFF : 0; break;
+                    case OP_LT:  result = difference < 0 ? 0xFFFF : 0; break;
+                    case OP_AND: result = x & y; break;
+                    case OP_OR:  result = x | y; break;
+                    default: break;
+                }
+                push(vm, result);
+                break;
+            }
+            case C_PUSH:
+                if (command->operation == SEG_CONSTANT) {
+                    push(vm, (uint16_t) command->index);
+                } else {
+                    push(vm, readRam(vm, segmentAddress(vm, command->operation, command->index)));
+                }
+                break;
+            case C_POP: {
+                uint16_t address = segmentAddress(vm, command->operation, command->index);
+                writeRam(vm, address, pop(vm));
+                break;
+            }
+            case C_LABEL:
+                break;
+            case C_GOTO:
+                vm->pc = (size_t) command->target;
+                break;
+            case C_IF:
+                if (pop(vm) != 0) {
+                    vm->pc = (size_t) command->target;
+                }
+                break;
+            case C_FUNCTION:
+                if (command->function == vm->haltFunction) {
+                    vm->pc--;
+                    return VM_HALT;
+                }
+                for (int i = 0; i < command->index; i++) {
+                    push(vm, 0);
+                }
+                break;
+            case C_CALL:
+                if (vm->pc > 0xFFFF) {
+                    fprintf(stderr, "Error: Program too large for the interpreter's return addresses\n");
+                    return VM_ERROR;
+                }
+                push(vm, (uint16_t) vm->pc);
+                push(vm, LCL);
+                push(vm, ARG);
+                push(vm, THIS);
+                push(vm, THAT);
+                ARG = (uint16_t) (SP - command->index - 5);
+                LCL = SP;
+                vm->pc = (size_t) command->target;
+                break;
+            case C_RETURN: {
+                uint16_t frame = LCL;
+                uint16_t returnAddress = readRam(vm, frame - 5);
+                writeRam(vm, ARG, pop(vm));
+                SP = ARG + 1;
+                THAT = readRam(vm, frame - 1);
+                THIS = readRam(vm, frame - 2);
+                ARG = readRam(vm, frame - 3);
+                LCL = readRam(vm, frame - 4);
+                vm->pc = returnAddress;
+                *function = command->function;
+                return VM_RETURN;
+            }
+            default:
+                return VM_ERROR;
+        }
+    }
+    return VM_LIMIT;
+}
+
+/**
+ * @brief Forgets the RAM words written so far
+ *
+ * @param vm Pointer to the machine
+ */
+void clearDirty(VMMachine * vm) {
+    for (size_t i = 0; i < vm->dirtyCount; i++) {
+        vm->dirty[vm->dirtyList[i]] = 0;
+    }
+    vm->dirtyCount = 0;
+}
+
+/**
+ * @brief Frees all memory owned by the machine
+ *
+ * @param vm Pointer to the machine to clean up
+ */
+void cleanupVM(VMMachine * vm) {
+    free(vm->ram);
+    free(vm->dirty);
+    free(vm->dirtyList);
+    memset(vm, 0, sizeof(*vm));
+}
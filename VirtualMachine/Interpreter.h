@@ -0,0 +1,179 @@
+/**
+ * @file Interpreter.h
+ * @brief Reference interpreter for Hack Virtual Machine programs
+ *
+ * This header declares a direct interpreter for .vm files. It executes VM
+ * commands against the Hack memory map (SP, LCL, ARG, THIS and THAT in
+ * RAM[0..4], temp at RAM[5..12], and the static region, stack and heap of
+ * the layout the program was built for, see MemoryMap.h) without going
+ * through the translator, so it can serve as the reference side of the
+ * differential checker. Static variables are named exactly like the
+ * translator names them ("File.vm.i" in directory mode).
+ */
+
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "Config.h"
+#include "../Assembler/MemoryMap.h"
+
+// Interpreter Memory
+#define VM_RAM_SIZE         32768
+#define VM_RAM_SCREEN       16384
+#define VM_RAM_TEMP         5
+
+// Arithmetic Operations
+#define OP_ADD              0
+#define OP_SUB              1
+#define OP_NEG              2
+#define OP_EQ               3
+#define OP_GT               4
+#define OP_LT               5
+#define OP_AND              6
+#define OP_OR               7
+#define OP_NOT              8
+
+// Memory Segments
+#define SEG_CONSTANT        0
+#define SEG_LOCAL           1
+#define SEG_ARGUMENT        2
+#define SEG_THIS            3
+#define SEG_THAT            4
+#define SEG_POINTER         5
+#define SEG_TEMP            6
+#define SEG_STATIC          7
+
+// Run Results
+#define VM_RETURN           0
+#define VM_HALT             1
+#define VM_LIMIT            2
+#define VM_ERROR            3
+
+/**
+ * @brief One decoded VM command
+ *
+ * The meaning of the operand fields depends on the command type: for push
+ * and pop, segment and index address memory (index is the static slot for
+ * the static segment); for goto, if-goto and call, target is the command
+ * index to jump to; for function and call, index is the local or argument
+ * count.
+ */
+typedef struct VMCommand {
+    int type;                   // C_ARITHMETIC, C_PUSH, ...
+    int operation;              // Arithmetic operation or memory segment
+    int index;
+    int target;
+    int function;               // Function containing this command
+} VMCommand;
+
+/**
+ * @brief A static variable and the translator's name for it
+ */
+typedef struct VMStatic {
+    char * name;                // "File.vm.i" (directory mode) or "path/File.i"
+    uint16_t address;
+} VMStatic;
+
+/**
+ * @brief A loaded VM program
+ */
+typedef struct VMProgram {
+    VMCommand * commands;
+    size_t commandCount;
+    size_t commandCapacity;
+    char ** functions;          // Function names indexed by function id
+    int * functionStart;        // Command index of each function's "function" command
+    size_t functionCount;
+    size_t functionCapacity;
+    VMStatic * statics;         // Statics in order of first appearance
+    size_t staticCount;
+    size_t staticCapacity;
+    bool bootstrap;             // Directory programs start by calling Sys.init
+    MemoryMap layout;           // Static region, stack and heap of the program
+} VMProgram;
+
+/**
+ * @brief Execution state of the interpreter
+ */
+typedef struct VMMachine {
+    const VMProgram * program;
+    uint16_t * ram;
+    uint8_t * dirty;            // One flag per RAM word written since the last clearDirty
+    uint16_t * dirtyList;
+    size_t dirtyCount;
+    size_t pc;
+    uint64_t steps;             // Commands executed since reset
+    int haltFunction;           // Function id of Sys.halt, or -1
+    uint16_t heapBase;          // First heap word; heap and screen writes are dirty
+    uint16_t heapLimit;         // Last heap word
+    struct VMStats * stats;     // Execution statistics to update, or NULL
+} VMMachine;
+
+/**
+ * @brief Loads every .vm file of a directory, or a single .vm file
+ *
+ * Files are read in the same order the translator reads them, so statics
+ * are laid out in the order the assembler would allocate them from the
+ * layout's static region.
+ *
+ * @param program Pointer to the program to fill
+ * @param path Directory or .vm file
+ * @param layout Memory map the program runs with
+ * @return true on success, false on I/O or parse errors
+ */
+bool loadVMProgram(VMProgram * program, const char * path, const MemoryMap * layout);
+
+/**
+ * @brief Looks up a function id by name
+ *
+ * @param program Pointer to the program
+ * @param name Fully qualified function name
+ * @return The function id, or -1 if the function is not defined
+ */
+int findVMFunction(const VMProgram * program, const char * name);
+
+/**
+ * @brief Frees all memory owned by a program
+ *
+ * @param program Pointer to the program to clean up
+ */
+void cleanupVMProgram(VMProgram * program);
+
+/**
+ * @brief Allocates memory and sets up the machine to run from Sys.init
+ *
+ * @param vm Pointer to the machine to initialize
+ * @param program Pointer to the loaded program
+ * @return true on success, false on allocation errors or a missing entry point
+ */
+bool initVM(VMMachine * vm, const VMProgram * program);
+
+/**
+ * @brief Executes commands until a function returns or the program halts
+ *
+ * On VM_RETURN, *function receives the id of the function that returned and
+ * the return value is on top of the caller's stack (RAM[SP - 1]).
+ * Calling Sys.halt, or falling off the end of a single-file program, halts.
+ *
+ * @param vm Pointer to the machine
+ * @param limit Step count at which to stop (0 for no limit)
+ * @param function Receives the id of the returning function
+ * @return VM_RETURN, VM_HALT, VM_LIMIT or VM_ERROR
+ */
+int runVM(VMMachine * vm, uint64_t limit, int * function);
+
+/**
+ * @brief Forgets the RAM words written so far
+ *
+ * @param vm Pointer to the machine
+ */
+void clearDirty(VMMachine * vm);
+
+/**
+ * @brief Frees all memory owned by the machine
+ *
+ * @param vm Pointer to the machine to clean up
+ */
+void cleanupVM(VMMachine * vm);
+
+#endif
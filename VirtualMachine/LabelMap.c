@@ -0,0 +1,165 @@
+/**
+ * @file LabelMap.c
+ * @brief Short label names for the Hack VM Translator
+ *
+ * This file implements the id assignment, the hash index and the map file
+ * written next to the assembly output by VMTranslator --short-labels.
+ */
+
+#include "LabelMap.h"
+#include "TranslatorStats.h"
+
+#define INITIAL_SLOTS   1024
+
+/**
+ * @brief Hashes a name with 32-bit FNV-1a
+ */
+static uint32_t hashName(const char * name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char * c = (const unsigned char *) name; *c != '\0'; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Formats an id as "$" followed by lowercase base-36 digits
+ */
+static void formatShortLabel(size_t id, char * shortName) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    char reversed[MAX_SHORT_LABEL_LENGTH];
+    int length = 0;
+    do {
+        reversed[length++] = digits[id % 36];
+        id /= 36;
+    } while (id > 0);
+
+    shortName[0] = '$';
+    for (int i = 0; i < length; i++) {
+        shortName[i + 1] = reversed[length - 1 - i];
+    }
+    shortName[length + 1] = '\0';
+}
+
+/**
+ * @brief Rebuilds the hash index with twice as many slots
+ *
+ * @return true on success, false on allocation failure
+ */
+static bool growSlots(LabelMap * labelMap) {
+    size_t slotCount = labelMap->slotCount ? labelMap->slotCount * 2 : INITIAL_SLOTS;
+    int32_t * slots = malloc(slotCount * sizeof(int32_t));
+    if (slots == NULL) {
+        return false;
+    }
+    memset(slots, 0xFF, slotCount * sizeof(int32_t));
+    for (size_t id = 0; id < labelMap->count; id++) {
+        size_t slot = hashName(labelMap->names[id]) & (slotCount - 1);
+        while (slots[slot] >= 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = (int32_t) id;
+    }
+    free(labelMap->slots);
+    labelMap->slots = slots;
+    labelMap->slotCount = slotCount;
+    return true;
+}
+
+/**
+ * @brief Initializes an empty label map
+ *
+ * @param labelMap Pointer to the label map
+ */
+void initLabelMap(LabelMap * labelMap) {
+    memset(labelMap, 0, sizeof(LabelMap));
+}
+
+/**
+ * @brief Returns the short name of a symbol, assigning the next id if new
+ *
+ * @param labelMap Pointer to the label map
+ * @param name Original symbol name
+ * @param shortName Buffer of MAX_SHORT_LABEL_LENGTH bytes receiving the short name
+ * @return true on success, false on allocation failure
+ */
+bool shortLabel(LabelMap * labelMap, const char * name, char * shortName) {
+    if (2 * (labelMap->count + 1) > labelMap->slotCount && !growSlots(labelMap)) {
+        return false;
+    }
+
+    size_t mask = labelMap->slotCount - 1;
+    size_t slot = hashName(name) & mask;
+    while (labelMap->slots[slot] >= 0) {
+        int32_t id = labelMap->slots[slot];
+        if (strcmp(labelMap->names[id], name) == 0) {
+            formatShortLabel((size_t) id, shortName);
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (labelMap->count == labelMap->capacity) {
+        size_t capacity = labelMap->capacity ? labelMap->capacity * 2 : INITIAL_SLOTS / 2;
+        char ** names = realloc(labelMap->names, capacity * sizeof(char *));
+        if (names == NULL) {
+            return false;
+        }
+        labelMap->names = names;
+        labelMap->capacity = capacity;
+    }
+    char * copy = countedStrdup(name);
+    if (copy == NULL) {
+        return false;
+    }
+    labelMap->names[labelMap->count] = copy;
+    labelMap->slots[slot] = (int32_t) labelMap->count;
+    formatShortLabel(labelMap->count, shortName);
+    labelMap->count++;
+    return true;
+}
+
+/**
+ * @brief Writes the map file, one "short original" line per id
+ *
+ * @param labelMap Pointer to the label map
+ * @param path Path of the map file
+ * @param bytesWritten Incremented by the number of bytes written
+ * @return 0 on success, 1 on error
+ */
+int writeLabelMap(const LabelMap * labelMap, const char * path, uint64_t * bytesWritten) {
+    FILE * mapFile = fopen(path, "w");
+    if (mapFile == NULL) {
+        fprintf(stderr, "Error: Failed to open map file %s\n", path);
+        return 1;
+    }
+
+    char shortName[MAX_SHORT_LABEL_LENGTH];
+    for (size_t id = 0; id < labelMap->count; id++) {
+        formatShortLabel(id, shortName);
+        int length = fprintf(mapFile, "%s %s\n", shortName, labelMap->names[id]);
+        if (length > 0) {
+            *bytesWritten += (uint64_t) length;
+        }
+    }
+
+    if (fclose(mapFile) != 0) {
+        fprintf(stderr, "Error: Failed to write map file %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Frees all memory owned by a label map
+ *
+ * @param labelMap Pointer to the label map
+ */
+void cleanupLabelMap(LabelMap * labelMap) {
+    for (size_t id = 0; id < labelMap->count; id++) {
+        free(labelMap->names[id]);
+    }
+    free(labelMap->names);
+    free(labelMap->slots);
+    initLabelMap(labelMap);
+}
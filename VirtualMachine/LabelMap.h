@@ -0,0 +1,68 @@
+/**
+ * @file LabelMap.h
+ * @brief Short label names for the Hack VM Translator
+ *
+ * This header declares the table behind VMTranslator --short-labels. Every
+ * assembly symbol the translator generates (function entries, return
+ * addresses, comparison and VM labels, static variables) is replaced by
+ * "$" followed by a base-36 id, given out in order of first use, so
+ * "PongGame.moveBall$IF_FALSE3" may become "$2k". The ids are dense, which
+ * lets readers of the sidecar .map file index the original names directly
+ * (see loadSymbols in Emulator/Loader.h). Lookups go through an
+ * open-addressing hash table keyed by FNV-1a.
+ */
+
+#ifndef LABELMAP_H
+#define LABELMAP_H
+
+#include "Config.h"
+
+// Longest short name: "$" and up to 7 base-36 digits
+#define MAX_SHORT_LABEL_LENGTH  9
+
+/**
+ * @brief Original names in id order with a hash index over them
+ */
+typedef struct LabelMap {
+    char ** names;              // Original names, indexed by id
+    size_t count;
+    size_t capacity;
+    int32_t * slots;            // Ids by hash, -1 for empty slots
+    size_t slotCount;           // Power of two, kept at least twice count
+} LabelMap;
+
+/**
+ * @brief Initializes an empty label map
+ *
+ * @param labelMap Pointer to the label map
+ */
+void initLabelMap(LabelMap * labelMap);
+
+/**
+ * @brief Returns the short name of a symbol, assigning the next id if new
+ *
+ * @param labelMap Pointer to the label map
+ * @param name Original symbol name
+ * @param shortName Buffer of MAX_SHORT_LABEL_LENGTH bytes receiving the short name
+ * @return true on success, false on allocation failure
+ */
+bool shortLabel(LabelMap * labelMap, const char * name, char * shortName);
+
+/**
+ * @brief Writes the map file, one "short original" line per id
+ *
+ * @param labelMap Pointer to the label map
+ * @param path Path of the map file
+ * @param bytesWritten Incremented by the number of bytes written
+ * @return 0 on success, 1 on error
+ */
+int writeLabelMap(const LabelMap * labelMap, const char * path, uint64_t * bytesWritten);
+
+/**
+ * @brief Frees all memory owned by a label map
+ *
+ * @param labelMap Pointer to the label map
+ */
+void cleanupLabelMap(LabelMap * labelMap);
+
+#endif
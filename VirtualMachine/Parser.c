@@ -3,12 +3,14 @@
  * @brief Virtual Machine language parsing module for the Hack VM Translator
  * 
  * This file contains functions for parsing Hack Virtual Machine language commands,
- * including command type identification, argument extraction, and whitespace
- * removal. The parser handles all VM command types including arithmetic,
- * memory access, program flow, and function calls.
+ * including command type identification and argument extraction, on lines
+ * already trimmed by the line scanner (see LineScanner.h). The parser handles
+ * all VM command types including arithmetic, memory access, program flow, and
+ * function calls.
  */
 
 #include "Parser.h"
+#include "TranslatorStats.h"
 
 /**
  * @brief Determines the type of VM command
@@ -22,7 +24,7 @@
  * @return Command type constant (C_ARITHMETIC, C_PUSH, C_POP, etc.)
  */
 int getCommandType(const char * line) {
-    char * lineCopy = strdup(line);
+    char * lineCopy = countedStrdup(line);
     if (lineCopy == NULL) {
         return C_UNKNOWN;
     }
@@ -73,38 +75,6 @@ int getCommandType(const char * line) {
     return result;
 }
 
-/**
- * @brief Removes whitespace and comments from VM command line
- * 
- * Strips leading/trailing whitespace and removes inline comments
- * (everything from // to end of line) from a VM command.
- * 
- * @param line The VM command line to clean
- * @return Pointer to cleaned line, or NULL if line is empty after cleaning
- */
-char * removeWhitespace(char * line) {
-    char * comment = strstr(line, "//");
-    if (comment) {
-        *comment = '\0';
-    }
-
-    while (*line && isspace(*line)) {
-        line++;
-    }
-
-    char * end = line + strlen(line) - 1;
-    while (end > line && isspace(*end)) {
-        *end = '\0';
-        end--;
-    }
-
-    if (*line == '\0') {
-        return NULL;
-    }
-
-    return line;
-}
-
 /**
  * @brief Extracts the first argument from a VM command
  * 
@@ -118,7 +88,7 @@ char * removeWhitespace(char * line) {
  * @return Pointer to the extracted argument, or NULL if extraction fails
  */
 char * getArg1(const char * line, int commandType, char * buffer, size_t bufferSize) {
-    char * lineCopy = strdup(line);
+    char * lineCopy = countedStrdup(line);
     if (lineCopy == NULL) {
         return NULL;
     }
@@ -163,7 +133,7 @@ char * getArg1(const char * line, int commandType, char * buffer, size_t bufferS
  * @return Pointer to the extracted argument, or NULL if extraction fails
  */
 char * getArg2(const char * line, char * buffer, size_t bufferSize) {
-    char * lineCopy = strdup(line);
+    char * lineCopy = countedStrdup(line);
     if (lineCopy == NULL) {
         return NULL;
     }
@@ -3,8 +3,8 @@
  * @brief Virtual Machine language parsing header for the Hack VM Translator
  * 
  * This header file declares functions for parsing Hack Virtual Machine language
- * commands, including command type identification, argument extraction, and
- * whitespace removal. The parser handles all VM command types.
+ * commands, including command type identification and argument extraction on
+ * lines trimmed by the line scanner. The parser handles all VM command types.
  */
 
 #ifndef PARSE_H
@@ -20,14 +20,6 @@
  */
 int getCommandType(const char * line);
 
-/**
- * @brief Removes whitespace and comments from VM command line
- * 
- * @param line The VM command line to clean
- * @return Pointer to cleaned line, or NULL if line is empty after cleaning
- */
-char * removeWhitespace(char * line);
-
 /**
  * @brief Extracts the first argument from a VM command
  * 
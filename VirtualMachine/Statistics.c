@@ -0,0 +1,270 @@
+/**
+ * @file Statistics.c
+ * @brief Dynamic execution statistics for the VM interpreter
+ *
+ * Every command is reduced to a key (its opcode, plus the segment for push
+ * and pop). Keys index flat counter arrays, so counting a command, a bigram
+ * and a trigram costs three increments. Labels are counted too: a label
+ * between two commands is a jump target, which is where fusing them into
+ * one template stops being possible.
+ */
+
+#include "Statistics.h"
+
+static const char * const keyNames[KEY_COUNT] = {
+    "add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not",
+    "push constant", "push local", "push argument", "push this",
+    "push that", "push pointer", "push temp", "push static",
+    "pop constant", "pop local", "pop argument", "pop this",
+    "pop that", "pop pointer", "pop temp", "pop static",
+    "label", "goto", "if-goto", "function", "call", "return"
+};
+
+/**
+ * @brief A counted key sequence, used to rank bigrams and trigrams
+ */
+typedef struct Sequence {
+    size_t index;
+    uint64_t count;
+} Sequence;
+
+/**
+ * @brief Allocates zeroed counters for a program
+ *
+ * @param stats Pointer to the counters to initialize
+ * @param program Pointer to the loaded program
+ * @return true on success, false if allocation failed
+ */
+bool initStats(VMStats * stats, const VMProgram * program) {
+    memset(stats, 0, sizeof(VMStats));
+    stats->previous[0] = -1;
+    stats->previous[1] = -1;
+    stats->functionCount = program->functionCount;
+    stats->trigrams = calloc((size_t) KEY_COUNT * KEY_COUNT * KEY_COUNT, sizeof(uint64_t));
+    stats->calls = calloc(program->functionCount + 1, sizeof(uint64_t));
+    stats->active = calloc(program->functionCount + 1, sizeof(uint32_t));
+    stats->maxActive = calloc(program->functionCount + 1, sizeof(uint32_t));
+    if (stats->trigrams == NULL || stats->calls == NULL || stats->active == NULL || stats->maxActive == NULL) {
+        cleanupStats(stats);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the key of a command
+ */
+static inline int commandKey(const VMCommand * command) {
+    switch (command->type) {
+        case C_ARITHMETIC:  return command->operation;
+        case C_PUSH:        return KEY_PUSH + command->operation;
+        case C_POP:         return KEY_POP + command->operation;
+        case C_LABEL:       return KEY_LABEL;
+        case C_GOTO:        return KEY_GOTO;
+        case C_IF:          return KEY_IF;
+        case C_FUNCTION:    return KEY_FUNCTION;
+        case C_CALL:        return KEY_CALL;
+        default:            return KEY_RETURN;
+    }
+}
+
+/**
+ * @brief Counts one executed command
+ *
+ * Function entries are counted at the "function" command, so the bootstrap
+ * call to Sys.init is included, and activations end at "return".
+ *
+ * @param stats Pointer to the counters
+ * @param command The command about to execute
+ */
+void recordStep(VMStats * stats, const VMCommand * command) {
+    int key = commandKey(command);
+    stats->steps++;
+    stats->keys[key]++;
+    if (stats->previous[1] >= 0) {
+        stats->bigrams[stats->previous[1] * KEY_COUNT + key]++;
+        if (stats->previous[0] >= 0) {
+            stats->trigrams[(stats->previous[0] * KEY_COUNT + stats->previous[1]) * KEY_COUNT + key]++;
+        }
+    }
+    stats->previous[0] = stats->previous[1];
+    stats->previous[1] = key;
+
+    if (command->function < 0) {
+        return;
+    }
+    if (key == KEY_FUNCTION) {
+        size_t function = (size_t) command->function;
+        stats->calls[function]++;
+        if (++stats->active[function] > stats->maxActive[function]) {
+            stats->maxActive[function] = stats->active[function];
+        }
+        if (++stats->depth > stats->maxDepth) {
+            stats->maxDepth = stats->depth;
+        }
+    } else if (key == KEY_RETURN) {
+        if (stats->active[command->function] > 0) {
+            stats->active[command->function]--;
+        }
+        if (stats->depth > 0) {
+            stats->depth--;
+        }
+    }
+}
+
+/**
+ * @brief Orders sequences by descending count, then by index
+ */
+static int compareSequences(const void * first, const void * second) {
+    const Sequence * a = first;
+    const Sequence * b = second;
+    if (a->count != b->count) {
+        return a->count < b->count ? 1 : -1;
+    }
+    return a->index < b->index ? -1 : (a->index > b->index);
+}
+
+/**
+ * @brief Writes a JSON string, escaping quotes and backslashes
+ */
+static void writeString(FILE * outputFile, const char * text) {
+    fputc('"', outputFile);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') {
+            fputc('\\', outputFile);
+        }
+        fputc(*text, outputFile);
+    }
+    fputc('"', outputFile);
+}
+
+/**
+ * @brief Writes the most frequent sequences of a given length
+ *
+ * @param outputFile Stream receiving the report
+ * @param name JSON member name
+ * @param counts Flat counter array indexed by the sequence's keys
+ * @param length Sequence length (2 or 3)
+ * @return true on success, false if allocation failed
+ */
+static bool writeSequences(FILE * outputFile, const char * name, const uint64_t * counts, int length) {
+    size_t total = length == 2 ? (size_t) KEY_COUNT * KEY_COUNT : (size_t) KEY_COUNT * KEY_COUNT * KEY_COUNT;
+    Sequence * sequences = malloc(total * sizeof(Sequence));
+    if (sequences == NULL) {
+        return false;
+    }
+
+    size_t used = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (counts[i] > 0) {
+            sequences[used].index = i;
+            sequences[used++].count = counts[i];
+        }
+    }
+    qsort(sequences, used, sizeof(Sequence), compareSequences);
+
+    fprintf(outputFile, "  \"%s\": [", name);
+    for (size_t i = 0; i < used && i < STATS_TOP_SEQUENCES; i++) {
+        size_t index = sequences[i].index;
+        int keys[3];
+        for (int k = length - 1; k >= 0; k--) {
+            keys[k] = (int) (index % KEY_COUNT);
+            index /= KEY_COUNT;
+        }
+
+        fprintf(outputFile, "%s\n    {\"sequence\": [", i ? "," : "");
+        for (int k = 0; k < length; k++) {
+            fprintf(outputFile, "%s\"%s\"", k ? ", " : "", keyNames[keys[k]]);
+        }
+        fprintf(outputFile, "], \"count\": %llu}", (unsigned long long) sequences[i].count);
+    }
+    fprintf(outputFile, "\n  ],\n");
+    free(sequences);
+    return true;
+}
+
+/**
+ * @brief Writes the counters as a JSON report
+ *
+ * Functions are listed by descending call count; functions that never ran
+ * are omitted.
+ *
+ * @param stats Pointer to the counters
+ * @param program Pointer to the program the counters belong to
+ * @param outputFile Stream receiving the report
+ */
+void writeStats(const VMStats * stats, const VMProgram * program, FILE * outputFile) {
+    fprintf(outputFile, "{\n  \"steps\": %llu,\n  \"maxCallDepth\": %u,\n", (unsigned long long) stats->steps, stats->maxDepth);
+
+    fprintf(outputFile, "  \"opcodes\": {");
+    static const char * const flowNames[] = {"label", "goto", "if-goto", "function", "call", "return"};
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+    for (int segment = 0; segment < 8; segment++) {
+        pushes += stats->keys[KEY_PUSH + segment];
+        pops += stats->keys[KEY_POP + segment];
+    }
+    for (int key = 0; key < KEY_PUSH; key++) {
+        fprintf(outputFile, "%s\n    \"%s\": %llu", key ? "," : "", keyNames[key], (unsigned long long) stats->keys[key]);
+    }
+    fprintf(outputFile, ",\n    \"push\": %llu,\n    \"pop\": %llu", (unsigned long long) pushes, (unsigned long long) pops);
+    for (int key = KEY_LABEL; key < KEY_COUNT; key++) {
+        fprintf(outputFile, ",\n    \"%s\": %llu", flowNames[key - KEY_LABEL], (unsigned long long) stats->keys[key]);
+    }
+    fprintf(outputFile, "\n  },\n");
+
+    fprintf(outputFile, "  \"segments\": {");
+    bool first = true;
+    for (int key = KEY_PUSH; key < KEY_LABEL; key++) {
+        if (key == KEY_POP + SEG_CONSTANT) {
+            continue;
+        }
+        fprintf(outputFile, "%s\n    \"%s\": %llu", first ? "" : ",", keyNames[key], (unsigned long long) stats->keys[key]);
+        first = false;
+    }
+    fprintf(outputFile, "\n  },\n");
+
+    if (!writeSequences(outputFile, "bigrams", stats->bigrams, 2) ||
+        !writeSequences(outputFile, "trigrams", stats->trigrams, 3)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+
+    Sequence * functions = malloc((program->functionCount + 1) * sizeof(Sequence));
+    size_t used = 0;
+    for (size_t i = 0; functions != NULL && i < program->functionCount; i++) {
+        if (stats->calls[i] > 0) {
+            functions[used].index = i;
+            functions[used++].count = stats->calls[i];
+        }
+    }
+    if (functions != NULL) {
+        qsort(functions, used, sizeof(Sequence), compareSequences);
+    }
+
+    fprintf(outputFile, "  \"functions\": [");
+    for (size_t i = 0; i < used; i++) {
+        size_t function = functions[i].index;
+        fprintf(outputFile, "%s\n    {\"name\": ", i ? "," : "");
+        writeString(outputFile, program->functions[function]);
+        fprintf(outputFile, ", \"calls\": %llu, \"maxRecursion\": %u}",
+                (unsigned long long) stats->calls[function], stats->maxActive[function]);
+    }
+    fprintf(outputFile, "\n  ]\n}\n");
+    free(functions);
+}
+
+/**
+ * @brief Frees all memory owned by the counters
+ *
+ * @param stats Pointer to the counters to clean up
+ */
+void cleanupStats(VMStats * stats) {
+    free(stats->trigrams);
+    free(stats->calls);
+    free(stats->active);
+    free(stats->maxActive);
+    stats->trigrams = NULL;
+    stats->calls = NULL;
+    stats->active = NULL;
+    stats->maxActive = NULL;
+}
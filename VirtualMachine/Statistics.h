@@ -0,0 +1,83 @@
+/**
+ * @file Statistics.h
+ * @brief Dynamic execution statistics for the VM interpreter
+ *
+ * This header declares counters that the interpreter updates for every
+ * executed VM command when statistics are enabled: executed opcodes,
+ * opcode and segment pairs, dynamic bigrams and trigrams of consecutive
+ * commands, calls per function and recursion depth. The report is written
+ * as JSON so that it can drive decisions about CodeWriter templates and
+ * command fusions.
+ */
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include "Config.h"
+#include "Interpreter.h"
+
+// Command Keys: arithmetic operations, then push and pop per segment, then flow and function commands
+#define KEY_PUSH            9
+#define KEY_POP             17
+#define KEY_LABEL           25
+#define KEY_GOTO            26
+#define KEY_IF              27
+#define KEY_FUNCTION        28
+#define KEY_CALL            29
+#define KEY_RETURN          30
+#define KEY_COUNT           31
+
+// Report Limits
+#define STATS_TOP_SEQUENCES 25
+
+/**
+ * @brief Execution counters
+ */
+typedef struct VMStats {
+    uint64_t steps;
+    uint64_t keys[KEY_COUNT];
+    uint64_t bigrams[KEY_COUNT * KEY_COUNT];
+    uint64_t * trigrams;        // KEY_COUNT^3 counters
+    int previous[2];            // Keys of the two previous commands, or -1
+    uint64_t * calls;           // Entries per function
+    uint32_t * active;          // Activations currently on the stack per function
+    uint32_t * maxActive;       // Maximum simultaneous activations per function
+    size_t functionCount;
+    uint32_t depth;             // Current call depth
+    uint32_t maxDepth;
+} VMStats;
+
+/**
+ * @brief Allocates zeroed counters for a program
+ *
+ * @param stats Pointer to the counters to initialize
+ * @param program Pointer to the loaded program
+ * @return true on success, false if allocation failed
+ */
+bool initStats(VMStats * stats, const VMProgram * program);
+
+/**
+ * @brief Counts one executed command
+ *
+ * @param stats Pointer to the counters
+ * @param command The command about to execute
+ */
+void recordStep(VMStats * stats, const VMCommand * command);
+
+/**
+ * @brief Writes the counters as a JSON report
+ *
+ * @param stats Pointer to the counters
+ * @param program Pointer to the program the counters belong to
+ * @param outputFile Stream receiving the report
+ */
+void writeStats(const VMStats * stats, const VMProgram * program, FILE * outputFile);
+
+/**
+ * @brief Frees all memory owned by the counters
+ *
+ * @param stats Pointer to the counters to clean up
+ */
+void cleanupStats(VMStats * stats);
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file TranslatorStats.c
+ * @brief Phase timing and work counters for the Hack VM Translator
+ *
+ * This file implements the phase clock, the allocation counter and the
+ * report printed by VMTranslator --stats.
+ */
+
+#include "TranslatorStats.h"
+
+#include <time.h>
+
+static uint64_t allocations = 0;
+
+/**
+ * @brief Returns a monotonic wall-clock time in seconds
+ */
+static double currentSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Clears the counters and starts timing the parse phase
+ *
+ * @param stats Pointer to the counters
+ * @param enabled Whether phase times should be measured
+ */
+void initTranslatorStats(TranslatorStats * stats, bool enabled) {
+    memset(stats, 0, sizeof(TranslatorStats));
+    stats->enabled = enabled;
+    stats->phase = PHASE_PARSE;
+    if (enabled) {
+        stats->phaseStart = currentSeconds();
+    }
+}
+
+/**
+ * @brief Charges the time since the last switch to the current phase
+ *
+ * @param stats Pointer to the counters
+ * @param phase Phase to charge from now on
+ */
+void switchPhase(TranslatorStats * stats, int phase) {
+    if (!stats->enabled) {
+        return;
+    }
+    double now = currentSeconds();
+    stats->phaseSeconds[stats->phase] += now - stats->phaseStart;
+    stats->phase = phase;
+    stats->phaseStart = now;
+}
+
+/**
+ * @brief Duplicates a string like strdup and counts the allocation
+ *
+ * @param text String to copy
+ * @return The copy, or NULL on failure
+ */
+char * countedStrdup(const char * text) {
+    char * copy = strdup(text);
+    if (copy != NULL) {
+        allocations++;
+    }
+    return copy;
+}
+
+/**
+ * @brief Allocates or grows memory like realloc and counts the allocation
+ *
+ * @param memory Block to grow, or NULL for a new one
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedRealloc(void * memory, size_t size) {
+    void * larger = realloc(memory, size);
+    if (larger != NULL) {
+        allocations++;
+    }
+    return larger;
+}
+
+/**
+ * @brief Prints phase times and counters
+ *
+ * @param stats Pointer to the counters
+ * @param outputFile Stream receiving the report
+ */
+void printTranslatorStats(const TranslatorStats * stats, FILE * outputFile) {
+    static const char * const phaseNames[PHASE_COUNT] = {"parse", "codegen", "write"};
+    static const char * const commandNames[COMMAND_TYPES] = {
+        "arithmetic", "push", "pop", "label", "goto", "if-goto", "function", "return", "call"
+    };
+
+    double total = 0;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        total += stats->phaseSeconds[phase];
+    }
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        fprintf(outputFile, "%-12s %10.3f ms %5.1f%%\n", phaseNames[phase], stats->phaseSeconds[phase] * 1e3,
+                total > 0 ? 100.0 * stats->phaseSeconds[phase] / total : 0.0);
+    }
+    fprintf(outputFile, "%-12s %10.3f ms\n", "total", total * 1e3);
+
+    uint64_t commands = 0;
+    for (int type = 0; type < COMMAND_TYPES; type++) {
+        commands += stats->commands[type];
+    }
+    fprintf(outputFile, "Files:                %llu\n", (unsigned long long) stats->files);
+    fprintf(outputFile, "Lines:                %llu\n", (unsigned long long) stats->lines);
+    fprintf(outputFile, "Commands:             %llu (", (unsigned long long) commands);
+    for (int type = 0; type < COMMAND_TYPES; type++) {
+        fprintf(outputFile, "%s%s %llu", type ? ", " : "", commandNames[type], (unsigned long long) stats->commands[type]);
+    }
+    fprintf(outputFile, ")\n");
+
+    fprintf(outputFile, "Symbols defined:      %llu\n", (unsigned long long) stats->symbols);
+    fprintf(outputFile, "Heap allocations:     %llu\n", (unsigned long long) allocations);
+    fprintf(outputFile, "Bytes written:        %llu\n", (unsigned long long) stats->bytesWritten);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file TranslatorStats.h
+ * @brief Phase timing and work counters for the Hack VM Translator
+ *
+ * This header declares the counters printed by VMTranslator --stats: wall
+ * time of the parse, code generation and write phases, input lines, VM
+ * commands by type, the assembly labels the generated code defines, heap
+ * allocations and output bytes. Parsing and code generation alternate for
+ * every command, so their times are accumulated by switching the current
+ * phase, which only reads the clock when statistics are enabled.
+ */
+
+#ifndef TRANSLATORSTATS_H
+#define TRANSLATORSTATS_H
+
+#include "Config.h"
+
+// Phases
+#define PHASE_PARSE         0
+#define PHASE_CODEGEN       1
+#define PHASE_WRITE         2
+#define PHASE_COUNT         3
+
+// Command type counters are indexed by C_ARITHMETIC..C_CALL
+#define COMMAND_TYPES       (C_CALL + 1)
+
+/**
+ * @brief Counters collected during one translation
+ */
+typedef struct TranslatorStats {
+    bool enabled;
+    int phase;                  // Phase whose time is currently accumulating
+    double phaseStart;
+    double phaseSeconds[PHASE_COUNT];
+    uint64_t files;
+    uint64_t lines;             // Input lines, including blank and comment lines
+    uint64_t commands[COMMAND_TYPES];
+    uint64_t symbols;           // Assembly labels defined by the generated code
+    uint64_t bytesWritten;
+} TranslatorStats;
+
+/**
+ * @brief Clears the counters and starts timing the parse phase
+ *
+ * @param stats Pointer to the counters
+ * @param enabled Whether phase times should be measured
+ */
+void initTranslatorStats(TranslatorStats * stats, bool enabled);
+
+/**
+ * @brief Charges the time since the last switch to the current phase
+ *
+ * @param stats Pointer to the counters
+ * @param phase Phase to charge from now on
+ */
+void switchPhase(TranslatorStats * stats, int phase);
+
+/**
+ * @brief Duplicates a string like strdup and counts the allocation
+ *
+ * @param text String to copy
+ * @return The copy, or NULL on failure
+ */
+char * countedStrdup(const char * text);
+
+/**
+ * @brief Allocates or grows memory like realloc and counts the allocation
+ *
+ * Used as the line scanner's allocator, so file buffers and line indexes
+ * are counted too (see setLineScannerAllocator).
+ *
+ * @param memory Block to grow, or NULL for a new one
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
+ */
+void * countedRealloc(void * memory, size_t size);
+
+/**
+ * @brief Prints phase times and counters
+ *
+ * @param stats Pointer to the counters
+ * @param outputFile Stream receiving the report
+ */
+void printTranslatorStats(const TranslatorStats * stats, FILE * outputFile);
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file VMRunner.c
+ * @brief Native runner for Hack Virtual Machine programs
+ *
+ * This file contains the entry point of VMRunner, which executes .vm files
+ * directly on the reference interpreter (see Interpreter.h) without
+ * translating or assembling them. With --stats it also records what the
+ * program actually executes (see Statistics.h) and writes a JSON report.
+ * Programs translated for another memory map are run with the same
+ * --statics, --stack and --heap options that were given to the translator.
+ */
+
+#include "Config.h"
+#include "Interpreter.h"
+#include "Statistics.h"
+
+/**
+ * @brief Command line options
+ */
+typedef struct Options {
+    const char * vmName;
+    const char * statsName;     // Report file, "-" for stdout, or NULL
+    uint64_t stepLimit;
+    MemoryMap layout;           // Layout the program was translated for
+} Options;
+
+/**
+ * @brief Prints command line usage
+ */
+static void printUsage(void) {
+    fprintf(stderr,
+            "Usage: VMRunner [OPTIONS] PATH\n"
+            "  PATH                 Directory of .vm files, or a single .vm file\n"
+            "  --steps N            Stop after N VM commands (default: no limit)\n"
+            "  --stats FILE         Write execution statistics as JSON (- for stdout)\n"
+            "  " MEMORY_MAP_USAGE "\n"
+            "                       Memory map given to the translator (default: 16:255, 256:2047, 2048:16383)\n");
+}
+
+/**
+ * @brief Parses command line arguments
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @param options Pointer to the options to fill
+ * @return true on success, false if usage should be printed
+ */
+static bool parseArguments(int argc, char * argv[], Options * options) {
+    memset(options, 0, sizeof(Options));
+    initMemoryMap(&options->layout);
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        int layoutOption = parseMemoryMapOption(&options->layout, argc, argv, &i);
+        if (layoutOption < 0) {
+            return false;
+        } else if (layoutOption > 0) {
+            continue;
+        } else if (strcmp(argv[i], "--steps") == 0 && hasValue) {
+            options->stepLimit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stats") == 0 && hasValue) {
+            options->statsName = argv[++i];
+        } else if (argv[i][0] == '-' || options->vmName != NULL) {
+            return false;
+        } else {
+            options->vmName = argv[i];
+        }
+    }
+    return options->vmName != NULL && validateMemoryMap(&options->layout);
+}
+
+/**
+ * @brief Writes the statistics report to a file or stdout
+ *
+ * @param stats Pointer to the counters
+ * @param program Pointer to the program
+ * @param name File name, or "-" for stdout
+ * @return true on success, false if the file could not be written
+ */
+static bool saveStats(const VMStats * stats, const VMProgram * program, const char * name) {
+    if (strcmp(name, "-") == 0) {
+        writeStats(stats, program, stdout);
+        return true;
+    }
+
+    FILE * outputFile = fopen(name, "w");
+    if (outputFile == NULL) {
+        fprintf(stderr, "Error: Cannot open file %s\n", name);
+        return false;
+    }
+    writeStats(stats, program, outputFile);
+    return fclose(outputFile) == 0;
+}
+
+/**
+ * @brief Main entry point for the VM runner
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return 0 if the program halted or reached the step limit, 1 on error
+ */
+int main(int argc, char * argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    VMProgram program;
+    VMMachine vm;
+    VMStats stats;
+    memset(&vm, 0, sizeof(vm));
+    memset(&stats, 0, sizeof(stats));
+
+    if (!loadVMProgram(&program, options.vmName, &options.layout)) {
+        return 1;
+    }
+
+    int result = 1;
+    if (!initVM(&vm, &program)) {
+        goto cleanup;
+    }
+    if (options.statsName != NULL) {
+        if (!initStats(&stats, &program)) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            goto cleanup;
+        }
+        vm.stats = &stats;
+    }
+
+    int status;
+    int function;
+    do {
+        status = runVM(&vm, options.stepLimit, &function);
+    } while (status == VM_RETURN);
+
+    if (status == VM_ERROR) {
+        fprintf(stderr, "Error: Execution failed after %llu steps\n", (unsigned long long) vm.steps);
+    } else {
+        fprintf(stderr, "%s after %llu steps\n", status == VM_HALT ? "Halted" : "Stopped",
+                (unsigned long long) vm.steps);
+        result = 0;
+    }
+
+    if (options.statsName != NULL && !saveStats(&stats, &program, options.statsName)) {
+        result = 1;
+    }
+
+cleanup:
+    cleanupStats(&stats);
+    cleanupVM(&vm);
+    cleanupVMProgram(&program);
+    return result;
+}
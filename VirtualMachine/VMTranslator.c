@@ -6,11 +6,123 @@
  * which translates Hack Virtual Machine (.vm) files into Hack assembly language (.asm).
  * The translator supports both single file and directory processing, handling
  * all VM commands including arithmetic, memory access, program flow, and function calls.
+ * With --stats it reports the time spent parsing, generating and writing code
+ * together with command, symbol, allocation and output counts. The bootstrap
+ * follows the memory map given by --statics, --stack and --heap (see
+ * MemoryMap.h), which is rejected when its regions overlap. With
+ * --short-labels every generated symbol is replaced by a short id and the
+ * original names are written to a .map file next to the output.
  */
 
 #include "Config.h"
 #include "CodeWriter.h"
+#include "LabelMap.h"
 #include "Parser.h"
+#include "../Assembler/LineScanner.h"
+#include "TranslatorStats.h"
+
+/**
+ * @brief Translates one .vm file
+ *
+ * Reads the whole file, indexes its command lines in one scan (see
+ * LineScanner.h) and appends the assembly for every command to the output
+ * stream. Time spent between reading a command and dispatching it
+ * is charged to parsing; time spent in the code writer to code generation.
+ *
+ * @param inputPath Path of the .vm file
+ * @param outputFile Stream receiving the generated assembly
+ * @param stats Pointer to the statistics counters
+ * @return 0 on success, 1 on error
+ */
+static int translateFile(const char * inputPath, FILE * outputFile, TranslatorStats * stats) {
+    size_t size;
+    char * text = readSourceFile(inputPath, &size);
+    LineIndex lines = {0};
+    if (text == NULL || !buildLineIndex(&lines, text, size)) {
+        fprintf(stderr, "Error: Failed to read input file %s\n", inputPath);
+        free(text);
+        freeLineIndex(&lines);
+        return 1;
+    }
+    stats->files++;
+    stats->lines += lines.totalLines;
+
+    char currLine[MAX_LINE_LENGTH];
+    char arg1Buffer[MAX_ARG_LENGTH];
+    char arg2Buffer[MAX_ARG_LENGTH];
+    int status = 0;
+
+    for (size_t i = 0; i < lines.count; i++) {
+        char * trimmed = currLine;
+        if (!copySourceLine(text, &lines.lines[i], currLine, sizeof(currLine))) {
+            fprintf(stderr, "Error: Line %u of %s is too long\n", lines.lines[i].number, inputPath);
+            status = 1;
+            break;
+        }
+
+        int commandType = getCommandType(trimmed);
+        if (commandType == C_UNKNOWN) {
+            fprintf(stderr, "Error: Unknown command type\n");
+            status = 1;
+            break;
+        }
+        stats->commands[commandType]++;
+
+        if (commandType == C_RETURN) {
+            switchPhase(stats, PHASE_CODEGEN);
+            writeReturn(outputFile);
+            switchPhase(stats, PHASE_PARSE);
+            continue;
+        }
+
+        char * arg1 = getArg1(trimmed, commandType, arg1Buffer, sizeof(arg1Buffer));
+        if (arg1 == NULL) {
+            fprintf(stderr, "Error: Failed to get first argument\n");
+            status = 1;
+            break;
+        }
+
+        if (commandType == C_PUSH || commandType == C_POP || commandType == C_FUNCTION || commandType == C_CALL) {
+            char * arg2 = getArg2(trimmed, arg2Buffer, sizeof(arg2Buffer));
+            if (arg2 == NULL) {
+                fprintf(stderr, "Error: Failed to get second argument\n");
+                status = 1;
+                break;
+            }
+
+            switchPhase(stats, PHASE_CODEGEN);
+            if (commandType == C_PUSH || commandType == C_POP) {
+                writePushPop(outputFile, commandType, arg1, arg2);
+            } else if (commandType == C_FUNCTION) {
+                writeFunction(outputFile, arg1, atoi(arg2));
+                stats->symbols++;
+            } else {
+                writeCall(outputFile, arg1, atoi(arg2));
+                stats->symbols++;
+            }
+        } else {
+            switchPhase(stats, PHASE_CODEGEN);
+            if (commandType == C_ARITHMETIC) {
+                writeArithmetic(outputFile, arg1);
+                if (strcmp(arg1, "eq") == 0 || strcmp(arg1, "gt") == 0 || strcmp(arg1, "lt") == 0) {
+                    stats->symbols += 2;
+                }
+            } else if (commandType == C_LABEL) {
+                writeLabel(outputFile, arg1);
+                stats->symbols++;
+            } else if (commandType == C_GOTO) {
+                writeGoto(outputFile, arg1);
+            } else {
+                writeIf(outputFile, arg1);
+            }
+        }
+        switchPhase(stats, PHASE_PARSE);
+    }
+
+    free(text);
+    freeLineIndex(&lines);
+    return status;
+}
 
 /**
  * @brief Main entry point for the Hack Virtual Machine Translator
@@ -18,253 +130,167 @@
  * Processes command line arguments and orchestrates the translation of VM code
  * to assembly code. Supports both single file and directory processing modes.
  * For directories, processes all .vm files and generates a single .asm output
- * file. For single files, generates a corresponding .asm file.
+ * file. For single files, generates a corresponding .asm file. The generated
+ * code is collected in memory and written out in one piece at the end.
  * 
  * @param argc Number of command line arguments
  * @param argv Array of command line argument strings
  * @return 0 on successful translation, 1 on error
  */
 int main(int argc, char * argv[]) {
-    if (argc != 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
-        fprintf(stderr, "Usage: VMTranslator [FILE]\n");
+    bool printStatistics = false;
+    bool shortLabels = false;
+    char * fileName = NULL;
+    MemoryMap memoryMap;
+    initMemoryMap(&memoryMap);
+    for (int i = 1; i < argc; i++) {
+        int layoutOption = parseMemoryMapOption(&memoryMap, argc, argv, &i);
+        if (layoutOption < 0) {
+            return 1;
+        } else if (layoutOption > 0) {
+            continue;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            printStatistics = true;
+        } else if (strcmp(argv[i], "--short-labels") == 0) {
+            shortLabels = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 || fileName != NULL) {
+            fileName = NULL;
+            break;
+        } else {
+            fileName = argv[i];
+        }
+    }
+    if (fileName == NULL) {
+        fprintf(stderr, "Usage: VMTranslator [--stats] [--short-labels] " MEMORY_MAP_USAGE " [FILE]\n");
         return 1;
-    }    
+    }
+    if (!validateMemoryMap(&memoryMap)) {
+        return 1;
+    }
+    setLineScannerAllocator(countedRealloc);
 
-    char * fileName = argv[1];
+    TranslatorStats stats;
+    initTranslatorStats(&stats, printStatistics);
+    LabelMap labelMap;
+    initLabelMap(&labelMap);
+    if (shortLabels) {
+        setLabelMap(&labelMap);
+    }
 
-    struct stat pathStat;
-    if (stat(fileName, &pathStat) == 0) {
-        if (S_ISDIR(pathStat.st_mode)) {
-            char * dirName = strrchr(fileName, '/');
-            if (dirName == NULL) {
-                dirName = fileName;
-            } else {
-                dirName++;
-            }
-            
-            char outputFileName[strlen(fileName) + strlen(dirName) + 6];
-            snprintf(outputFileName, sizeof(outputFileName), "%s/%s.asm", fileName, dirName);
-            
-            FILE * outputFile = fopen(outputFileName, "w");
-            if (outputFile == NULL) {
-                fprintf(stderr, "Error: Failed to open output file %s\n", outputFileName);
-                return 1;
-            }
-            
-            writeInit(outputFile);
-            DIR * dir = opendir(fileName);
-            if (dir == NULL) {
-                fprintf(stderr, "Error: Failed to open directory\n");
-                fclose(outputFile);
-                return 1;
-            }
+    char * codeBuffer = NULL;
+    size_t codeSize = 0;
+    FILE * codeFile = open_memstream(&codeBuffer, &codeSize);
+    if (codeFile == NULL) {
+        fprintf(stderr, "Error: Failed to allocate output buffer\n");
+        return 1;
+    }
 
-            struct dirent * entry;
-            while ((entry = readdir(dir)) != NULL) {
-                char * extension = strrchr(entry->d_name, '.');
-                if (extension == NULL || strcmp(extension, ".vm") != 0) {
-                    continue;
-                }
+    // Room for "PATH/NAME.asm", whose NAME is at most the whole path
+    char outputFileName[2 * strlen(fileName) + 6];
+    int status = 0;
+    struct stat pathStat;
+    if (stat(fileName, &pathStat) != 0) {
+        fprintf(stderr, "Error: File not found\n");
+        fclose(codeFile);
+        free(codeBuffer);
+        return 1;
+    } else if (S_ISDIR(pathStat.st_mode)) {
+        char * dirName = strrchr(fileName, '/');
+        if (dirName == NULL) {
+            dirName = fileName;
+        } else {
+            dirName++;
+        }
 
-                char fullPath[MAX_PATH_LENGTH];
-                snprintf(fullPath, sizeof(fullPath), "%s/%s", fileName, entry->d_name);
-                
-                FILE * inputFile = fopen(fullPath, "r");
-                if (inputFile == NULL) {
-                    fprintf(stderr, "Error: Failed to input file\n");
-                    closedir(dir);
-                    fclose(outputFile);
-                    return 1;
-                }
-                
-                setFile(entry->d_name);
+        snprintf(outputFileName, sizeof(outputFileName), "%s/%s.asm", fileName, dirName);
 
-                char currLine[MAX_LINE_LENGTH];
-                char arg1Buffer[MAX_ARG_LENGTH];
-                char arg2Buffer[MAX_ARG_LENGTH];
-                
-                while (fgets(currLine, sizeof(currLine), inputFile)) {
-                    char * trimmed = removeWhitespace(currLine);
-                    if (trimmed == NULL) {
-                        continue;
-                    }
+        DIR * dir = opendir(fileName);
+        if (dir == NULL) {
+            fprintf(stderr, "Error: Failed to open directory\n");
+            fclose(codeFile);
+            free(codeBuffer);
+            return 1;
+        }
 
-                    int commandType = getCommandType(trimmed);
-                    if (commandType == C_UNKNOWN) {
-                        fprintf(stderr, "Error: Unknown command type\n");
-                        fclose(inputFile);
-                        closedir(dir);
-                        fclose(outputFile);
-                        return 1;
-                    }
+        switchPhase(&stats, PHASE_CODEGEN);
+        writeInit(codeFile, &memoryMap);
+        stats.symbols += 2;
+        switchPhase(&stats, PHASE_PARSE);
 
-                    if (commandType == C_RETURN) {
-                        writeReturn(outputFile);
-                        continue;
-                    }
-                    
-                    char * arg1 = getArg1(trimmed, commandType, arg1Buffer, sizeof(arg1Buffer));
-                    if (arg1 == NULL) {
-                        fprintf(stderr, "Error: Failed to get first argument\n");
-                        fclose(inputFile);
-                        closedir(dir);
-                        fclose(outputFile);
-                        return 1;
-                    }
-                    
-                    if (commandType == C_PUSH || commandType == C_POP || commandType == C_FUNCTION || commandType == C_CALL) {
-                        char * arg2 = getArg2(trimmed, arg2Buffer, sizeof(arg2Buffer));
-                        if (arg2 == NULL) {
-                            fprintf(stderr, "Error: Failed to get second argument\n");
-                            fclose(inputFile);
-                            closedir(dir);
-                            fclose(outputFile);
-                            return 1;
-                        }
-                        
-                        if (commandType == C_PUSH || commandType == C_POP) {
-                            writePushPop(outputFile, commandType, arg1, arg2);
-                        } else if (commandType == C_FUNCTION) {
-                            writeFunction(outputFile, arg1, atoi(arg2));
-                        } else if (commandType == C_CALL) {
-                            writeCall(outputFile, arg1, atoi(arg2));
-                        } else {
-                            fprintf(stderr, "Error: Unknown command type\n");
-                            fclose(inputFile);
-                            closedir(dir);
-                            fclose(outputFile);
-                            return 1;
-                        }
-                    } else {
-                        if (commandType == C_ARITHMETIC) {
-                            writeArithmetic(outputFile, arg1);
-                        } else if (commandType == C_LABEL) {
-                            writeLabel(outputFile, arg1);
-                        } else if (commandType == C_GOTO) {
-                            writeGoto(outputFile, arg1);
-                        } else if (commandType == C_IF) {
-                            writeIf(outputFile, arg1);
-                        } else {
-                            fprintf(stderr, "Error: Unknown command type\n");
-                            fclose(inputFile);
-                            closedir(dir);
-                            fclose(outputFile);
-                            return 1;
-                        }
-                    }
-                }
-                
-                fclose(inputFile);
-            }
-            
-            closedir(dir);
-            fclose(outputFile);
-            return 0;
-        } else if (S_ISREG(pathStat.st_mode)) {
-            char * extension = strrchr(fileName, '.');
+        struct dirent * entry;
+        while (status == 0 && (entry = readdir(dir)) != NULL) {
+            char * extension = strrchr(entry->d_name, '.');
             if (extension == NULL || strcmp(extension, ".vm") != 0) {
-                fprintf(stderr, "Error: Invalid file type\n");
-                return 1;
-            }
-            
-            FILE * inputFile = fopen(fileName, "r");
-            if (inputFile == NULL) {
-                fprintf(stderr, "Error: Failed to input file\n");
-                return 1;
-            }
-            
-            fileName[strlen(fileName) - 3] = '\0';
-            setFile(fileName);
-
-            char outputFileName[strlen(fileName) + 5];
-            snprintf(outputFileName, sizeof(outputFileName), "%s.asm", fileName);
-            
-            FILE * outputFile = fopen(outputFileName, "w");
-            if (outputFile == NULL) {
-                fprintf(stderr, "Error: Failed to open output file %s\n", outputFileName);
-                fclose(inputFile);
-                return 1;
+                continue;
             }
-            
-            char currLine[MAX_LINE_LENGTH];
-            char arg1Buffer[MAX_ARG_LENGTH];
-            char arg2Buffer[MAX_ARG_LENGTH];
-            
-            while (fgets(currLine, sizeof(currLine), inputFile)) {
-                char * trimmed = removeWhitespace(currLine);
-                if (trimmed == NULL) {
-                    continue;
-                }
-
-                int commandType = getCommandType(trimmed);
-                if (commandType == C_UNKNOWN) {
-                    fprintf(stderr, "Error: Unknown command type\n");
-                    fclose(inputFile);
-                    fclose(outputFile);
-                    return 1;
-                }
 
-                if (commandType == C_RETURN) {
-                    writeReturn(outputFile);
-                    continue;
-                }
-                
-                char * arg1 = getArg1(trimmed, commandType, arg1Buffer, sizeof(arg1Buffer));
-                if (arg1 == NULL) {
-                    fprintf(stderr, "Error: Failed to get first argument\n");
-                    fclose(inputFile);
-                    fclose(outputFile);
-                    return 1;
-                }
-                
-                if (commandType == C_PUSH || commandType == C_POP || commandType == C_FUNCTION || commandType == C_CALL) {
-                    char * arg2 = getArg2(trimmed, arg2Buffer, sizeof(arg2Buffer));
-                    if (arg2 == NULL) {
-                        fprintf(stderr, "Error: Failed to get second argument\n");
-                        fclose(inputFile);
-                        fclose(outputFile);
-                        return 1;
-                    }
-                    
-                    if (commandType == C_PUSH || commandType == C_POP) {
-                        writePushPop(outputFile, commandType, arg1, arg2);
-                    } else if (commandType == C_FUNCTION) {
-                        writeFunction(outputFile, arg1, atoi(arg2));
-                    } else if (commandType == C_CALL) {
-                        writeCall(outputFile, arg1, atoi(arg2));
-                    } else {
-                        fprintf(stderr, "Error: Unknown command type\n");
-                        fclose(inputFile);
-                        fclose(outputFile);
-                        return 1;
-                    }
-                } else {
-                    if (commandType == C_ARITHMETIC) {
-                        writeArithmetic(outputFile, arg1);
-                    } else if (commandType == C_LABEL) {
-                        writeLabel(outputFile, arg1);
-                    } else if (commandType == C_GOTO) {
-                        writeGoto(outputFile, arg1);
-                    } else if (commandType == C_IF) {
-                        writeIf(outputFile, arg1);
-                    } else {
-                        fprintf(stderr, "Error: Unknown command type\n");
-                        fclose(inputFile);
-                        fclose(outputFile);
-                        return 1;
-                    }
-                }
-            }
-            
-            fclose(inputFile);
-            fclose(outputFile);
-            return 0;
-        } else {
+            char fullPath[strlen(fileName) + strlen(entry->d_name) + 2];
+            snprintf(fullPath, sizeof(fullPath), "%s/%s", fileName, entry->d_name);
+            setFile(entry->d_name);
+            status = translateFile(fullPath, codeFile, &stats);
+        }
+        closedir(dir);
+    } else if (S_ISREG(pathStat.st_mode)) {
+        char * extension = strrchr(fileName, '.');
+        if (extension == NULL || strcmp(extension, ".vm") != 0) {
             fprintf(stderr, "Error: Invalid file type\n");
+            fclose(codeFile);
+            free(codeBuffer);
             return 1;
         }
+
+        char inputPath[strlen(fileName) + 1];
+        strcpy(inputPath, fileName);
+
+        fileName[strlen(fileName) - 3] = '\0';
+        setFile(fileName);
+        snprintf(outputFileName, sizeof(outputFileName), "%s.asm", fileName);
+        status = translateFile(inputPath, codeFile, &stats);
     } else {
-        fprintf(stderr, "Error: File not found\n");
+        fprintf(stderr, "Error: Invalid file type\n");
+        fclose(codeFile);
+        free(codeBuffer);
         return 1;
     }
-}
\ No newline at end of file
+
+    if (status == 0) {
+        switchPhase(&stats, PHASE_CODEGEN);
+        stats.symbols += writeEnd(codeFile);
+        switchPhase(&stats, PHASE_PARSE);
+    }
+    fclose(codeFile);
+    if (status != 0) {
+        cleanupLabelMap(&labelMap);
+        free(codeBuffer);
+        return status;
+    }
+
+    switchPhase(&stats, PHASE_WRITE);
+    FILE * outputFile = fopen(outputFileName, "w");
+    if (outputFile == NULL) {
+        fprintf(stderr, "Error: Failed to open output file %s\n", outputFileName);
+        cleanupLabelMap(&labelMap);
+        free(codeBuffer);
+        return 1;
+    }
+    stats.bytesWritten = fwrite(codeBuffer, 1, codeSize, outputFile);
+    fclose(outputFile);
+
+    // The map sits next to the output; a stale one would rename a later build's symbols
+    char mapFileName[strlen(outputFileName) + 1];
+    snprintf(mapFileName, sizeof(mapFileName), "%.*s.map", (int) (strlen(outputFileName) - 4), outputFileName);
+    if (shortLabels) {
+        status = writeLabelMap(&labelMap, mapFileName, &stats.bytesWritten);
+    } else {
+        remove(mapFileName);
+    }
+    switchPhase(&stats, PHASE_PARSE);
+
+    if (printStatistics) {
+        printTranslatorStats(&stats, stderr);
+    }
+
+    cleanupLabelMap(&labelMap);
+    free(codeBuffer);
+    return status;
+}
@@ -0,0 +1,271 @@
+"""
+Toolchain Benchmark Suite.
+
+Builds every benchmark program with the whole toolchain (Jack compiler, VM
+translator, assembler), runs it on the native emulator, and records:
+
+    compileSeconds  Wall-clock time of the Jack compiler over the program and the OS (best of three)
+    vmLines         VM commands produced by the compiler
+    romWords        Instructions in the assembled program
+    cycles          Instructions executed until Sys.halt
+    peakStack       Highest stack usage in words
+    peakHeap        Highest heap address written, in words above the heap base
+
+Results are written as JSON and compared against the checked-in baseline;
+a metric regresses when it exceeds its baseline value by more than the
+threshold stored next to the baseline.
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BENCH_DIRECTORY = os.path.join(ROOT, "bench")
+COMPILER = os.path.join(ROOT, "Compiler", "JackCompiler.py")
+TRANSLATOR = os.path.join(ROOT, "VirtualMachine", "VMTranslator")
+ASSEMBLER = os.path.join(ROOT, "Assembler", "Assembler")
+EMULATOR = os.path.join(ROOT, "Emulator", "Emulator")
+OS_DIRECTORY = os.path.join(ROOT, "JackOS")
+
+DEFAULT_BASELINE = os.path.join(BENCH_DIRECTORY, "baseline.json")
+DEFAULT_OUTPUT = os.path.join(BENCH_DIRECTORY, "results.json")
+
+# Benchmarks: name, directory of .jack sources, keyboard script or None
+BENCHMARKS = [
+    ("Sort", os.path.join(BENCH_DIRECTORY, "Sort"), None),
+    ("Sieve", os.path.join(BENCH_DIRECTORY, "Sieve"), None),
+    ("Matrix", os.path.join(BENCH_DIRECTORY, "Matrix"), None),
+    ("Strings", os.path.join(BENCH_DIRECTORY, "Strings"), None),
+    ("HeapChurn", os.path.join(BENCH_DIRECTORY, "HeapChurn"), None),
+    ("Drawing", os.path.join(BENCH_DIRECTORY, "Drawing"), None),
+    ("Text", os.path.join(BENCH_DIRECTORY, "Text"), None),
+    ("Pong", os.path.join(ROOT, "Compiler", "Pong"), os.path.join(BENCH_DIRECTORY, "Pong.keys")),
+]
+
+# Keyboard scripts count calls to this function rather than cycles. Pong reads
+# the keyboard once per frame, so its game, and its cycle count, do not depend
+# on how fast the code runs between frames.
+KEY_FUNCTION = "Keyboard.keyPressed"
+
+METRICS = ["compileSeconds", "vmLines", "romWords", "cycles", "peakStack", "peakHeap"]
+
+# Runs that have not halted after this many instructions are reported as failures
+CYCLE_LIMIT = 10000000000
+
+# Compiler runs per benchmark; the fastest one is recorded
+COMPILE_REPEATS = 3
+
+
+class BenchmarkError(Exception):
+    """Raised when a benchmark fails to build or does not halt."""
+
+
+def run(command, cwd=None):
+    """
+    Runs a toolchain command and returns its standard error.
+
+    Args:
+        command: Argument list of the command
+        cwd: Working directory, or None for the current one
+
+    Returns:
+        The command's standard error output
+
+    Raises:
+        BenchmarkError: If the command exits with a non-zero status
+    """
+    process = subprocess.run(command, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    if process.returncode != 0:
+        raise BenchmarkError(f"{os.path.basename(command[0])} failed: {process.stderr.strip() or process.stdout.strip()}")
+    return process.stderr
+
+
+def countVMLines(directory):
+    """
+    Counts VM commands in every .vm file of a directory.
+
+    Args:
+        directory: Directory containing the compiled .vm files
+
+    Returns:
+        The number of non-blank, non-comment lines
+    """
+    count = 0
+    for path in glob.glob(os.path.join(directory, "*.vm")):
+        with open(path, "r") as file:
+            for line in file:
+                line = line.strip()
+                if line and not line.startswith("//"):
+                    count += 1
+    return count
+
+
+def measure(name, sourceDirectory, keysFile, workDirectory):
+    """
+    Builds and runs one benchmark.
+
+    The program's classes are copied next to the JackOS classes, compiled,
+    translated as a directory and assembled with a symbol file, then executed
+    on the emulator without HLE so that every JackOS routine is counted.
+
+    Args:
+        name: Benchmark name, also used as the build directory name
+        sourceDirectory: Directory of the program's .jack files
+        keysFile: Keyboard script for the emulator, or None
+        workDirectory: Scratch directory for build products
+
+    Returns:
+        A dictionary mapping each metric to its value
+
+    Raises:
+        BenchmarkError: If a tool fails, the program calls Sys.error or it
+            does not halt
+    """
+    directory = os.path.join(workDirectory, name)
+    os.makedirs(directory)
+    for path in glob.glob(os.path.join(OS_DIRECTORY, "*.jack")) + glob.glob(os.path.join(sourceDirectory, "*.jack")):
+        shutil.copy(path, directory)
+
+    compileSeconds = None
+    for _ in range(COMPILE_REPEATS):
+        start = time.perf_counter()
+        run([sys.executable, COMPILER, directory], cwd=os.path.dirname(COMPILER))
+        elapsed = time.perf_counter() - start
+        compileSeconds = elapsed if compileSeconds is None else min(compileSeconds, elapsed)
+
+    run([TRANSLATOR, directory])
+    run([ASSEMBLER, "-s", os.path.join(directory, name + ".asm")])
+    with open(os.path.join(directory, name + ".hack"), "r") as file:
+        romWords = sum(1 for line in file if line.strip())
+
+    command = [EMULATOR, "--peaks", "--cycles", str(CYCLE_LIMIT)]
+    if keysFile is not None:
+        command += ["--keys", keysFile, "--key-calls", KEY_FUNCTION]
+    report = run(command + [os.path.join(directory, name + ".hack")])
+
+    failed = re.search(r"Sys\.error\((-?\d+)\) called after (\d+) cycles", report)
+    if failed is not None:
+        raise BenchmarkError(f"program called Sys.error({failed.group(1)}) after {failed.group(2)} cycles")
+    halted = re.search(r"Halted at PC \d+ after (\d+) cycles", report)
+    peaks = re.search(r"Peak stack (\d+) words, peak heap (\d+) words", report)
+    if halted is None or peaks is None:
+        raise BenchmarkError(f"program did not halt within {CYCLE_LIMIT} cycles")
+
+    return {
+        "compileSeconds": round(compileSeconds, 3),
+        "vmLines": countVMLines(directory),
+        "romWords": romWords,
+        "cycles": int(halted.group(1)),
+        "peakStack": int(peaks.group(1)),
+        "peakHeap": int(peaks.group(2)),
+    }
+
+
+def compare(results, baseline):
+    """
+    Prints every metric next to its baseline and finds regressions.
+
+    Args:
+        results: Dictionary of benchmark name to metrics
+        baseline: Parsed baseline file with "thresholds" and "benchmarks"
+
+    Returns:
+        A list of "Benchmark.metric" names that regressed
+    """
+    thresholds = baseline.get("thresholds", {})
+    expected = baseline.get("benchmarks", {})
+    regressions = []
+
+    print(f"{'Benchmark':<10} {'Metric':<15} {'Baseline':>12} {'Current':>12} {'Change':>9}")
+    for name, metrics in results.items():
+        for metric in METRICS:
+            value = metrics[metric]
+            reference = expected.get(name, {}).get(metric)
+            if reference is None:
+                print(f"{name:<10} {metric:<15} {'-':>12} {value:>12} {'new':>9}")
+                continue
+
+            change = (value - reference) / reference if reference else (0.0 if value == reference else float("inf"))
+            flag = ""
+            if value > reference * (1 + thresholds.get(metric, 0.0)):
+                flag = "  REGRESSION"
+                regressions.append(f"{name}.{metric}")
+            print(f"{name:<10} {metric:<15} {reference:>12} {value:>12} {change:>+8.2%}{flag}")
+    return regressions
+
+
+def main():
+    """
+    Main entry point for the benchmark suite.
+
+    Command line usage:
+        python3 bench/Bench.py [--only NAME,...] [--output FILE] [--baseline FILE] [--update-baseline]
+
+    Exits with status 1 if a benchmark fails or any metric regresses
+    beyond its threshold.
+    """
+    parser = argparse.ArgumentParser(description="Run the toolchain benchmark suite")
+    parser.add_argument("--only", help="comma-separated benchmark names to run")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="JSON file receiving the results")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="JSON baseline to compare against")
+    parser.add_argument("--update-baseline", action="store_true", help="replace the baseline's values with these results")
+    arguments = parser.parse_args()
+
+    selected = BENCHMARKS
+    if arguments.only:
+        names = arguments.only.split(",")
+        selected = [benchmark for benchmark in BENCHMARKS if benchmark[0] in names]
+        unknown = set(names) - {benchmark[0] for benchmark in selected}
+        if unknown:
+            print(f"Error: Unknown benchmarks {', '.join(sorted(unknown))}")
+            sys.exit(1)
+
+    for tool in (TRANSLATOR, ASSEMBLER, EMULATOR):
+        if not os.path.isfile(tool):
+            print(f"Error: {tool} not found (run make first)")
+            sys.exit(1)
+
+    results = {}
+    failed = False
+    with tempfile.TemporaryDirectory(prefix="hackbench") as workDirectory:
+        for name, sourceDirectory, keysFile in selected:
+            try:
+                results[name] = measure(name, sourceDirectory, keysFile, workDirectory)
+            except BenchmarkError as error:
+                print(f"Error: {name}: {error}")
+                failed = True
+
+    with open(arguments.output, "w") as file:
+        json.dump({"benchmarks": results}, file, indent=2)
+        file.write("\n")
+
+    baseline = {"thresholds": {}, "benchmarks": {}}
+    if os.path.isfile(arguments.baseline):
+        with open(arguments.baseline, "r") as file:
+            baseline = json.load(file)
+
+    regressions = compare(results, baseline)
+
+    if arguments.update_baseline and not failed:
+        baseline.setdefault("benchmarks", {}).update(results)
+        with open(arguments.baseline, "w") as file:
+            json.dump(baseline, file, indent=2)
+            file.write("\n")
+        print(f"Baseline updated: {arguments.baseline}")
+    elif regressions:
+        print(f"Regressions: {', '.join(regressions)}")
+        failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()